@@ -1,9 +1,131 @@
+#define _GNU_SOURCE
 #include <time.h>
 #include <stdio.h>
+#include <stdint.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include "tsc_clock.h"
+
+// Clock characterization: for every clock ID, what one clock_gettime()
+// really costs, how finely the clock actually ticks compared with what
+// clock_getres() advertises, and whether reads are served by the vDSO
+// (no kernel entry) or fall through to the system call.
+
+#define CALLS      1000000      // clock_gettime() calls timed per clock
+#define SYS_CALLS  100000       // raw syscalls timed per clock
+#define STEP_NS    20000000     // time spent looking for the smallest step
+
+struct clock_desc {
+    clockid_t id;
+    const char *name;
+};
+
+static const struct clock_desc clocks[] = {
+    { CLOCK_REALTIME,           "REALTIME" },
+    { CLOCK_MONOTONIC,          "MONOTONIC" },
+    { CLOCK_MONOTONIC_RAW,      "MONOTONIC_RAW" },
+    { CLOCK_REALTIME_COARSE,    "REALTIME_COARSE" },
+    { CLOCK_MONOTONIC_COARSE,   "MONOTONIC_COARSE" },
+    { CLOCK_BOOTTIME,           "BOOTTIME" },
+    { CLOCK_TAI,                "TAI" },
+    { CLOCK_PROCESS_CPUTIME_ID, "PROCESS_CPUTIME_ID" },
+    { CLOCK_THREAD_CPUTIME_ID,  "THREAD_CPUTIME_ID" },
+};
+
+static uint64_t toNs(const struct timespec *ts)
+{
+    return (uint64_t)ts->tv_sec * 1000000000 + ts->tv_nsec;
+}
+
+static uint64_t nowNs(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return toNs(&ts);
+}
+
+// Average cost of one call through libc (vDSO when possible)
+static double libcCost(clockid_t id)
+{
+    struct timespec ts;
+    uint64_t t0;
+    long j;
+
+    t0 = nowNs();
+    for (j = 0; j < CALLS; j++)
+        clock_gettime(id, &ts);
+    return (double)(nowNs() - t0) / CALLS;
+}
+
+// Average cost of one call that always enters the kernel
+static double syscallCost(clockid_t id)
+{
+    struct timespec ts;
+    uint64_t t0;
+    long j;
+
+    t0 = nowNs();
+    for (j = 0; j < SYS_CALLS; j++)
+        syscall(SYS_clock_gettime, id, &ts);
+    return (double)(nowNs() - t0) / SYS_CALLS;
+}
+
+// Smallest nonzero difference between two consecutive reads
+static uint64_t observedStep(clockid_t id)
+{
+    struct timespec ts;
+    uint64_t prev, cur, step = UINT64_MAX, deadline;
+
+    clock_gettime(id, &ts);
+    prev = toNs(&ts);
+    deadline = nowNs() + STEP_NS;
+
+    while (nowNs() < deadline) {
+        clock_gettime(id, &ts);
+        cur = toNs(&ts);
+        if (cur != prev && cur - prev < step)
+            step = cur - prev;
+        prev = cur;
+    }
+    return step;
+}
+
+// The same two measurements for the calibrated TSC clock
+static double tscCost(struct tsc_clock *tc)
+{
+    uint64_t t0;
+    long j;
+
+    t0 = nowNs();
+    for (j = 0; j < CALLS; j++)
+        tcNow(tc);
+    return (double)(nowNs() - t0) / CALLS;
+}
+
+static uint64_t tscStep(struct tsc_clock *tc)
+{
+    uint64_t prev, cur, step = UINT64_MAX, deadline;
+
+    prev = tcNow(tc);
+    deadline = nowNs() + STEP_NS;
+
+    while (nowNs() < deadline) {
+        cur = tcNow(tc);
+        if (cur != prev && cur - prev < step)
+            step = cur - prev;
+        prev = cur;
+    }
+    return step;
+}
 
 int main() {
     struct timespec ts;
     struct timespec res;
+    struct tsc_clock tc;
+    double cost, sysCost;
+    uint64_t step;
+    size_t j;
 
     // CLOCK_REALTIME example
     clock_gettime(CLOCK_REALTIME, &ts);
@@ -24,6 +146,36 @@ int main() {
     printf("Monotonic: %ld seconds since boot\n", ts.tv_sec);
     printf("Monotonic resolution: %ld seconds, %ld nanoseconds\n", res.tv_sec, res.tv_nsec);
 
+    // Characterize every clock
+    printf("\n%-19s %12s %12s %10s %10s %8s\n", "clock", "resolution",
+           "observed", "ns/call", "sys-ns", "path");
+
+    for (j = 0; j < sizeof(clocks) / sizeof(clocks[0]); j++) {
+        if (clock_gettime(clocks[j].id, &ts) == -1 ||
+                clock_getres(clocks[j].id, &res) == -1) {
+            printf("%-19s unavailable\n", clocks[j].name);
+            continue;
+        }
+
+        cost = libcCost(clocks[j].id);
+        sysCost = syscallCost(clocks[j].id);
+        step = observedStep(clocks[j].id);
+
+        // A vDSO read never enters the kernel, so it costs a fraction of
+        // the forced system call; a fallback costs about the same
+        printf("%-19s %10lluns %10lluns %10.1f %10.1f %8s\n", clocks[j].name,
+               (unsigned long long)toNs(&res), (unsigned long long)step,
+               cost, sysCost, cost < 0.5 * sysCost ? "vdso" : "syscall");
+    }
+
+    // tsc_clock.c: MONOTONIC from rdtsc, or clock_gettime() as fallback
+    if (tcInit(&tc))
+        printf("%-19s %10.3fns %10lluns %10.1f %10s %8s\n", "TSC", 1.0 / tc.ghz,
+               (unsigned long long)tscStep(&tc), tscCost(&tc), "-", "tsc");
+    else
+        printf("%-19s %12s %10lluns %10.1f %10s %8s  (%s)\n", "TSC", "-",
+               (unsigned long long)tscStep(&tc), tscCost(&tc), "-",
+               "fallback", tc.why);
+
     return 0;
 }
-
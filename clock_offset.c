@@ -0,0 +1,90 @@
+// clock_offset.c
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/timerfd.h>
+#include "clock_offset.h"
+
+#define CO_TRIES     8                  /* Reads per measurement */
+#define CO_NEVER_SEC ((time_t)1 << 34)  /* Year 2514: never expires */
+
+static uint64_t coClockNs(clockid_t id)
+{
+    struct timespec ts;
+
+    clock_gettime(id, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+/* REALTIME - MONOTONIC from the tightest MONOTONIC/REALTIME/MONOTONIC
+   bracket of CO_TRIES */
+static int64_t coMeasure(void)
+{
+    uint64_t m0, r, m1, best = UINT64_MAX;
+    int64_t offset = 0;
+    int j;
+
+    for (j = 0; j < CO_TRIES; j++) {
+        m0 = coClockNs(CLOCK_MONOTONIC);
+        r = coClockNs(CLOCK_REALTIME);
+        m1 = coClockNs(CLOCK_MONOTONIC);
+        if (m1 - m0 < best) {
+            best = m1 - m0;
+            offset = (int64_t)(r - (m0 + (m1 - m0) / 2));
+        }
+    }
+    return offset;
+}
+
+/* Arm (or re-arm) the cancel-on-set timer; done before measuring, so a
+   step between the two is never missed */
+static int coArm(struct clock_offset *co)
+{
+    struct itimerspec its = { { 0, 0 }, { CO_NEVER_SEC, 0 } };
+
+    return timerfd_settime(co->fd, TFD_TIMER_ABSTIME | TFD_TIMER_CANCEL_ON_SET,
+                           &its, NULL);
+}
+
+int coInit(struct clock_offset *co)
+{
+    co->steps = 0;
+    co->fd = timerfd_create(CLOCK_REALTIME, TFD_NONBLOCK | TFD_CLOEXEC);
+    if (co->fd == -1)
+        return -1;
+
+    if (coArm(co) == -1) {
+        close(co->fd);
+        co->fd = -1;
+        return -1;
+    }
+    atomic_init(&co->offset, coMeasure());
+    return 0;
+}
+
+void coClose(struct clock_offset *co)
+{
+    if (co->fd != -1)
+        close(co->fd);
+    co->fd = -1;
+}
+
+int coCheck(struct clock_offset *co, int64_t *step)
+{
+    uint64_t expirations;
+    int64_t offset;
+
+    if (read(co->fd, &expirations, sizeof(expirations)) != -1 ||
+            errno == EAGAIN)
+        return 0;
+    if (errno != ECANCELED)
+        return -1;
+
+    if (coArm(co) == -1)
+        return -1;
+    offset = coMeasure();
+    *step = offset - coOffset(co);
+    atomic_store_explicit(&co->offset, offset, memory_order_relaxed);
+    co->steps++;
+    return 1;
+}
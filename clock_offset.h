@@ -0,0 +1,58 @@
+// clock_offset.h
+#ifndef CLOCK_OFFSET_H
+#define CLOCK_OFFSET_H
+
+#include <stdatomic.h>
+#include <stdint.h>
+
+/*
+ * CLOCK_REALTIME <-> CLOCK_MONOTONIC conversion from a cached offset.
+ *
+ * Both clocks are slewed identically by NTP, so REALTIME - MONOTONIC only
+ * changes when the wall clock is stepped (settimeofday(), clock_settime(),
+ * an NTP step, a leap second). coInit() measures the offset once and arms
+ * a CLOCK_REALTIME timerfd far in the future with TFD_TIMER_ABSTIME |
+ * TFD_TIMER_CANCEL_ON_SET; any step makes the descriptor readable and its
+ * read() fail with ECANCELED. Converting a timestamp is then one atomic
+ * load and an add instead of reading both clocks.
+ *
+ * coCheck() is the only call that enters the kernel: a non-blocking
+ * read() of the timerfd. Poll co->fd (e.g. in an epoll set) to call it
+ * only when the clock has actually been stepped. Deadlines that follow
+ * the wall clock can be kept as CLOCK_MONOTONIC ns together with the
+ * offset they were computed under, and moved by the difference once
+ * coOffset() changes.
+ */
+
+struct clock_offset {
+    int fd;                     /* CLOCK_REALTIME timerfd, cancel-on-set */
+    atomic_llong offset;        /* REALTIME - MONOTONIC, ns */
+    uint64_t steps;             /* Clock steps seen by coCheck() */
+};
+
+/* Returns 0 on success, -1 on error (errno set) */
+int coInit(struct clock_offset *co);
+
+void coClose(struct clock_offset *co);
+
+/* If the wall clock was stepped since the last check, remeasure the
+   offset, store the change in '*step' (REALTIME moved by that many ns)
+   and return 1. Returns 0 if not, -1 on error */
+int coCheck(struct clock_offset *co, int64_t *step);
+
+static inline int64_t coOffset(struct clock_offset *co)
+{
+    return atomic_load_explicit(&co->offset, memory_order_relaxed);
+}
+
+static inline uint64_t coToMono(struct clock_offset *co, uint64_t realNs)
+{
+    return realNs - coOffset(co);
+}
+
+static inline uint64_t coToReal(struct clock_offset *co, uint64_t monoNs)
+{
+    return monoNs + coOffset(co);
+}
+
+#endif
@@ -0,0 +1,252 @@
+#define _GNU_SOURCE
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <time.h>
+#include "tsc_clock.h"      /* TSC frequency, for the raw TSC */
+#include "tlpi_hdr.h"       /* Error handling functions */
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define HAVE_TSC 1
+#endif
+
+/*
+ * Cross-core clock skew and monotonicity checker.
+ *
+ * For every pair of CPUs two pinned threads take turns through one shared
+ * cache line: each waits for the other's timestamp, reads its own clock
+ * and passes the reading back. A reading taken after seeing the other
+ * core's reading must not be smaller; when it is, that is a monotonicity
+ * violation across cores. The sequence a1 -> b -> a2 also bounds the
+ * offset of B's clock relative to A's to [b - a2, b - a1]; the tightest
+ * bounds over all rounds are reported. An offset range that excludes 0
+ * means the clocks really are skewed by at least that much.
+ *
+ * With a single usable CPU, both threads share it: only the (same-core)
+ * monotonicity check is meaningful then.
+ */
+
+#define USAGE "%s [-n rounds-per-pair]\n"
+
+#define SPINS_BEFORE_YIELD 1000
+
+struct clock_src {
+    const char *name;
+    uint64_t (*read)(void);
+    double nsPerUnit;
+};
+
+/* The ping-pong line: 'turn' is even when A is to read, odd for B */
+struct pingpong {
+    atomic_ulong turn;
+    atomic_ulong stamp;
+    char pad[64 - 2 * sizeof(atomic_ulong)];
+} __attribute__((aligned(64)));
+
+struct pair_result {
+    long rounds;
+    long violations;
+    int64_t maxBack;            /* Largest backwards step seen, units */
+    int64_t offLo, offHi;       /* Offset of B relative to A, units */
+    uint64_t rttMin;            /* Fastest a1 -> a2 round trip, units */
+};
+
+struct side {
+    pthread_t thread;
+    int cpu;
+    int isB;
+};
+
+static struct pingpong line;
+static const struct clock_src *src;
+static long rounds = 100000;
+static struct pair_result res;
+
+static uint64_t readNs(clockid_t id)
+{
+    struct timespec ts;
+
+    clock_gettime(id, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static uint64_t readMonotonic(void)
+{
+    return readNs(CLOCK_MONOTONIC);
+}
+
+static uint64_t readMonotonicRaw(void)
+{
+    return readNs(CLOCK_MONOTONIC_RAW);
+}
+
+#ifdef HAVE_TSC
+static uint64_t readTsc(void)
+{
+    unsigned aux;
+    uint64_t t;
+
+    /* rdtscp waits for earlier loads (the partner's stamp); lfence keeps
+       later instructions from starting before the read */
+    t = __rdtscp(&aux);
+    _mm_lfence();
+    return t;
+}
+#endif
+
+static unsigned long waitTurn(unsigned long want)
+{
+    unsigned long t;
+    int spins = 0;
+
+    while ((t = atomic_load_explicit(&line.turn, memory_order_acquire)) != want)
+        if (++spins % SPINS_BEFORE_YIELD == 0)
+            sched_yield();      /* Needed when both share one CPU */
+    return t;
+}
+
+static void *sideFunc(void *arg)
+{
+    struct side *s = arg;
+    uint64_t prev, prevA = 0, now;
+    int64_t back;
+    long r;
+
+    for (r = 0; r < rounds; r++) {
+        waitTurn(2 * r + s->isB);
+        prev = atomic_load_explicit(&line.stamp, memory_order_relaxed);
+        now = src->read();
+
+        if (r > 0 || s->isB) {
+            back = (int64_t)(prev - now);
+            if (back > 0) {
+                res.violations++;
+                if (back > res.maxBack)
+                    res.maxBack = back;
+            }
+        }
+
+        if (s->isB) {
+            /* prev = a1 (A's stamp just before us) */
+            if ((int64_t)(now - prev) < res.offHi)
+                res.offHi = now - prev;
+        } else if (r > 0) {
+            /* prev = b, prevA = a1 of the last round, now = a2 */
+            if ((int64_t)(prev - now) > res.offLo)
+                res.offLo = prev - now;
+            if (now - prevA < res.rttMin)
+                res.rttMin = now - prevA;
+        }
+        prevA = now;
+
+        atomic_store_explicit(&line.stamp, now, memory_order_relaxed);
+        atomic_store_explicit(&line.turn, 2 * r + s->isB + 1, memory_order_release);
+    }
+    return NULL;
+}
+
+static void runPair(int cpuA, int cpuB)
+{
+    struct side a = { .cpu = cpuA, .isB = 0 }, b = { .cpu = cpuB, .isB = 1 };
+    struct side *sides[2] = { &a, &b };
+    pthread_attr_t attr;
+    cpu_set_t set;
+    int j, s;
+
+    memset(&res, 0, sizeof(res));
+    res.offLo = INT64_MIN;
+    res.offHi = INT64_MAX;
+    res.rttMin = UINT64_MAX;
+    res.rounds = rounds;
+    atomic_store(&line.turn, 0);
+    atomic_store(&line.stamp, 0);
+
+    for (j = 0; j < 2; j++) {
+        pthread_attr_init(&attr);
+        CPU_ZERO(&set);
+        CPU_SET(sides[j]->cpu, &set);
+        pthread_attr_setaffinity_np(&attr, sizeof(set), &set);
+        s = pthread_create(&sides[j]->thread, &attr, sideFunc, sides[j]);
+        if (s != 0) {
+            errno = s;
+            errExit("pthread_create");
+        }
+        pthread_attr_destroy(&attr);
+    }
+    for (j = 0; j < 2; j++)
+        pthread_join(sides[j]->thread, NULL);
+
+    /* The first round's B reading only has an a1, not an a2 */
+    if (res.offLo == INT64_MIN)
+        res.offLo = res.offHi;
+
+    printf("%-14s %4d %4d %9ld %10ld %12.1f %12.1f %12.1f %10.1f%s\n",
+           src->name, cpuA, cpuB, res.rounds, res.violations,
+           res.maxBack * src->nsPerUnit, res.offLo * src->nsPerUnit,
+           res.offHi * src->nsPerUnit, res.rttMin * src->nsPerUnit,
+           (res.offLo > 0 || res.offHi < 0) ? "  SKEWED" : "");
+    fflush(stdout);
+}
+
+int main(int argc, char *argv[])
+{
+    struct clock_src clocks[3] = {
+        { "MONOTONIC", readMonotonic, 1.0 },
+        { "MONOTONIC_RAW", readMonotonicRaw, 1.0 },
+    };
+    int cpus[CPU_SETSIZE], ncpus = 0, nclocks = 2, opt, c, a, b;
+    struct tsc_clock tc;
+    cpu_set_t avail;
+
+    while ((opt = getopt(argc, argv, "n:")) != -1) {
+        switch (opt) {
+        case 'n':
+            rounds = atol(optarg);
+            break;
+        default:
+            usageErr(USAGE, argv[0]);
+        }
+    }
+    if (optind != argc || rounds <= 1)
+        usageErr(USAGE, argv[0]);
+
+#ifdef HAVE_TSC
+    /* Raw TSC ticks, converted to ns only for printing */
+    tcInit(&tc);
+    if (tc.ghz == 0.0)
+        printf("TSC frequency unknown (%s): TSC columns are in ticks\n", tc.why);
+    clocks[nclocks].name = "TSC";
+    clocks[nclocks].read = readTsc;
+    clocks[nclocks++].nsPerUnit = tc.ghz ? 1.0 / tc.ghz : 1.0;
+#else
+    (void)tc;
+#endif
+
+    if (sched_getaffinity(0, sizeof(avail), &avail) == -1)
+        errExit("sched_getaffinity");
+    for (c = 0; c < CPU_SETSIZE; c++)
+        if (CPU_ISSET(c, &avail))
+            cpus[ncpus++] = c;
+
+    if (ncpus < 2)
+        printf("Only one usable CPU: checking same-core monotonicity only\n");
+
+    printf("%-14s %4s %4s %9s %10s %12s %12s %12s %10s\n", "clock", "cpuA",
+           "cpuB", "rounds", "violations", "max-back-ns", "offset-lo-ns",
+           "offset-hi-ns", "rtt-ns");
+
+    for (c = 0; c < nclocks; c++) {
+        src = &clocks[c];
+        if (ncpus < 2) {
+            runPair(cpus[0], cpus[0]);
+            continue;
+        }
+        for (a = 0; a < ncpus; a++)
+            for (b = a + 1; b < ncpus; b++)
+                runPair(cpus[a], cpus[b]);
+    }
+
+    exit(EXIT_SUCCESS);
+}
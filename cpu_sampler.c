@@ -0,0 +1,319 @@
+#define _GNU_SOURCE
+#include <fcntl.h>
+#include <stdint.h>
+#include <sys/timerfd.h>
+#include <time.h>
+#include "tlpi_hdr.h"       /* Error handling functions */
+
+/*
+ * CPU-time sampler for a set of processes: cpuID.c's
+ * clock_getcpuclockid() + clock_gettime() turned into a long-running
+ * monitor.
+ *
+ * Each PID's CPU-time clock ID is resolved once. One periodic
+ * CLOCK_MONOTONIC timerfd then drives every sample: per period there is
+ * one read() of the timerfd, one clock_gettime() per PID (CPU-time clocks
+ * are never served by the vDSO) and one write() of the output line. A
+ * process that has exited makes clock_gettime() fail (EINVAL, or ESRCH
+ * once its PID is gone) and is dropped from the set. A CPU time that went
+ * down means the PID was reused: that is reported as an exit and the new
+ * process is sampled from there on.
+ *
+ * Output is one line per period, listing only the processes that used
+ * CPU time:
+ *
+ *   <ms since start> <pid>:<cpu-us> ... [<pid>:x for each exit]
+ *
+ * -B instead times the clock-ID path against parsing /proc/<pid>/stat,
+ * both reopened on every sample and with the file kept open (pread()).
+ */
+
+#define USAGE "%s [-i interval-ms] [-n samples] [-B] {pid... | -}\n"
+
+#define LINE_BYTES 48           /* Upper bound on one " pid:cpu-us" field */
+#define BENCH_ROUNDS 200        /* -B: samples of the whole set per method */
+
+struct proc {
+    pid_t pid;
+    clockid_t clock;
+    uint64_t cpuNs;             /* At the previous sample */
+    int statFd;                 /* -B only */
+};
+
+static uint64_t cpuNs(clockid_t clock, int *ok)
+{
+    struct timespec ts;
+
+    *ok = clock_gettime(clock, &ts) == 0;
+    return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static uint64_t monotonicNs(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+/* Read PIDs from argv, or whitespace-separated from stdin for "-" */
+static pid_t *loadPids(int argc, char *argv[], int *n)
+{
+    pid_t *pids = NULL;
+    size_t cap = 0;
+    long pid;
+    int j, fromStdin = (argc == 1 && strcmp(argv[0], "-") == 0);
+
+    *n = 0;
+    for (j = 0; fromStdin || j < argc; j++) {
+        if (fromStdin) {
+            if (scanf("%ld", &pid) != 1)
+                break;
+        } else {
+            pid = atol(argv[j]);
+        }
+        if (pid <= 0)
+            usageErr("Bad PID: %ld\n", pid);
+
+        if ((size_t)*n == cap) {
+            cap = cap ? cap * 2 : 1024;
+            pids = realloc(pids, cap * sizeof(*pids));
+            if (pids == NULL)
+                errExit("realloc");
+        }
+        pids[(*n)++] = pid;
+    }
+    return pids;
+}
+
+/* Resolve every PID's CPU-time clock; unknown PIDs are reported and left
+   out. Returns the number of processes kept */
+static int resolve(const pid_t *pids, int npids, struct proc *procs)
+{
+    int j, n = 0, s, ok;
+
+    for (j = 0; j < npids; j++) {
+        s = clock_getcpuclockid(pids[j], &procs[n].clock);
+        if (s != 0) {
+            fprintf(stderr, "%ld: %s\n", (long)pids[j], strerror(s));
+            continue;
+        }
+        procs[n].pid = pids[j];
+        procs[n].statFd = -1;
+        procs[n].cpuNs = cpuNs(procs[n].clock, &ok);
+        if (ok)
+            n++;
+    }
+    return n;
+}
+
+static void sample(int nsamples, uint64_t intervalNs, struct proc *procs,
+                   int nprocs)
+{
+    struct itimerspec its;
+    char *line;
+    size_t len, size;
+    uint64_t expirations, start, now;
+    int tfd, j, k, ok, taken;
+
+    tfd = timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC);
+    if (tfd == -1)
+        errExit("timerfd_create");
+    its.it_interval.tv_sec = intervalNs / 1000000000;
+    its.it_interval.tv_nsec = intervalNs % 1000000000;
+    its.it_value = its.it_interval;
+    if (timerfd_settime(tfd, 0, &its, NULL) == -1)
+        errExit("timerfd_settime");
+
+    size = LINE_BYTES * (nprocs + 2);            /* + time, missed */
+    line = malloc(size);
+    if (line == NULL)
+        errExit("malloc");
+
+    printf("# cpu_sampler: %d process(es) every %llu ms; "
+           "ms pid:cpu-us ..., pid:x = exited\n", nprocs,
+           (unsigned long long)(intervalNs / 1000000));
+    fflush(stdout);
+
+    start = monotonicNs();
+    for (taken = 0; nprocs > 0 && (nsamples == 0 || taken < nsamples); taken++) {
+        if (read(tfd, &expirations, sizeof(expirations)) != sizeof(expirations))
+            errExit("read");
+        now = monotonicNs();
+        len = snprintf(line, size, "%llu",
+                       (unsigned long long)((now - start) / 1000000));
+
+        /* Exited processes are compacted out as the set is walked */
+        for (j = 0, k = 0; j < nprocs; j++) {
+            now = cpuNs(procs[j].clock, &ok);
+            if (!ok) {
+                len += snprintf(line + len, size - len, " %ld:x",
+                                (long)procs[j].pid);
+                continue;
+            }
+            if (now < procs[j].cpuNs)           /* PID reused */
+                len += snprintf(line + len, size - len, " %ld:x",
+                                (long)procs[j].pid);
+            else if (now / 1000 != procs[j].cpuNs / 1000)
+                len += snprintf(line + len, size - len, " %ld:%llu",
+                                (long)procs[j].pid,
+                                (unsigned long long)(now / 1000 -
+                                                     procs[j].cpuNs / 1000));
+            procs[j].cpuNs = now;
+            procs[k++] = procs[j];
+        }
+        nprocs = k;
+
+        if (expirations > 1)
+            len += snprintf(line + len, size - len, " # %llu missed",
+                            (unsigned long long)(expirations - 1));
+        line[len++] = '\n';
+        if (write(STDOUT_FILENO, line, len) != (ssize_t)len)
+            errExit("write");
+    }
+
+    free(line);
+    close(tfd);
+}
+
+/* utime + stime from /proc/<pid>/stat text, in ns; the comm field may
+   contain spaces and parentheses, so scan from the last ')' */
+static int parseStat(char *buf, ssize_t n, long tickNs, uint64_t *ns)
+{
+    unsigned long utime, stime;
+    char *p;
+
+    if (n <= 0)
+        return -1;
+    buf[n] = '\0';
+    p = strrchr(buf, ')');
+    if (p == NULL || sscanf(p + 2, "%*c %*d %*d %*d %*d %*d %*u %*u %*u "
+                            "%*u %*u %lu %lu", &utime, &stime) != 2)
+        return -1;
+    *ns = (uint64_t)(utime + stime) * tickNs;
+    return 0;
+}
+
+static uint64_t statOpenRead(pid_t pid, long tickNs)
+{
+    char path[64], buf[1024];
+    uint64_t ns = 0;
+    ssize_t n;
+    int fd;
+
+    snprintf(path, sizeof(path), "/proc/%ld/stat", (long)pid);
+    fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd == -1)
+        return 0;
+    n = read(fd, buf, sizeof(buf) - 1);
+    close(fd);
+    parseStat(buf, n, tickNs, &ns);
+    return ns;
+}
+
+static uint64_t statPread(int fd, long tickNs)
+{
+    char buf[1024];
+    uint64_t ns = 0;
+
+    parseStat(buf, pread(fd, buf, sizeof(buf) - 1, 0), tickNs, &ns);
+    return ns;
+}
+
+/* -B: cost of one process sample by each method */
+static void bench(struct proc *procs, int nprocs)
+{
+    char path[64];
+    long tickNs = 1000000000 / sysconf(_SC_CLK_TCK);
+    uint64_t t0, sink = 0, clockCost, openCost, preadCost;
+    int r, j, k, ok;
+
+    /* Processes that exited since resolve() are left out */
+    for (j = 0, k = 0; j < nprocs; j++) {
+        snprintf(path, sizeof(path), "/proc/%ld/stat", (long)procs[j].pid);
+        procs[j].statFd = open(path, O_RDONLY | O_CLOEXEC);
+        if (procs[j].statFd == -1) {
+            fprintf(stderr, "%s: %s\n", path, strerror(errno));
+            continue;
+        }
+        procs[k++] = procs[j];
+    }
+    nprocs = k;
+    if (nprocs == 0)
+        usageErr("No processes left to benchmark\n");
+
+    t0 = monotonicNs();
+    for (r = 0; r < BENCH_ROUNDS; r++)
+        for (j = 0; j < nprocs; j++)
+            sink += cpuNs(procs[j].clock, &ok);
+    clockCost = monotonicNs() - t0;
+
+    t0 = monotonicNs();
+    for (r = 0; r < BENCH_ROUNDS; r++)
+        for (j = 0; j < nprocs; j++)
+            sink += statOpenRead(procs[j].pid, tickNs);
+    openCost = monotonicNs() - t0;
+
+    t0 = monotonicNs();
+    for (r = 0; r < BENCH_ROUNDS; r++)
+        for (j = 0; j < nprocs; j++)
+            sink += statPread(procs[j].statFd, tickNs);
+    preadCost = monotonicNs() - t0;
+
+    for (j = 0; j < nprocs; j++)
+        close(procs[j].statFd);
+
+    printf("%d process(es) x %d rounds (checksum %llu)\n", nprocs,
+           BENCH_ROUNDS, (unsigned long long)(sink & 0xff));
+    printf("%-26s %10s %12s %12s\n", "method", "ns/sample", "resolution",
+           "syscalls");
+    printf("%-26s %10.0f %10dns %12d\n", "clock_gettime(cpu clock)",
+           (double)clockCost / BENCH_ROUNDS / nprocs, 1, 1);
+    printf("%-26s %10.0f %10ldns %12d\n", "/proc/<pid>/stat open+read",
+           (double)openCost / BENCH_ROUNDS / nprocs, tickNs, 3);
+    printf("%-26s %10.0f %10ldns %12d\n", "/proc/<pid>/stat pread",
+           (double)preadCost / BENCH_ROUNDS / nprocs, tickNs, 1);
+}
+
+int main(int argc, char *argv[])
+{
+    struct proc *procs;
+    pid_t *pids;
+    uint64_t intervalNs = 1000000000;
+    int opt, npids, nprocs, nsamples = 0, benchFlag = 0;
+
+    while ((opt = getopt(argc, argv, "i:n:B")) != -1) {
+        switch (opt) {
+        case 'i':
+            intervalNs = strtoull(optarg, NULL, 0) * 1000000;
+            break;
+        case 'n':
+            nsamples = atoi(optarg);
+            break;
+        case 'B':
+            benchFlag = 1;
+            break;
+        default:
+            usageErr(USAGE, argv[0]);
+        }
+    }
+
+    if (optind == argc || intervalNs == 0 || nsamples < 0)
+        usageErr(USAGE, argv[0]);
+
+    pids = loadPids(argc - optind, &argv[optind], &npids);
+    procs = calloc(npids ? npids : 1, sizeof(*procs));
+    if (procs == NULL)
+        errExit("calloc");
+    nprocs = resolve(pids, npids, procs);
+    free(pids);
+    if (nprocs == 0)
+        usageErr("No processes to sample\n");
+
+    if (benchFlag)
+        bench(procs, nprocs);
+    else
+        sample(nsamples, intervalNs, procs, nprocs);
+
+    exit(EXIT_SUCCESS);
+}
@@ -0,0 +1,150 @@
+#define _POSIX_C_SOURCE 199309
+#include <signal.h>
+#include <stdint.h>
+#include <time.h>
+#include "tlpi_hdr.h"       /* Error handling functions */
+
+/*
+ * Measures how far a periodic job drifts from its ideal phase grid
+ * (start + k * period) under three ways of scheduling it:
+ *
+ *   relative  - re-arm a one-shot with flags = 0 and it_value = period
+ *               after each expiration (latency accumulates every period)
+ *   interval  - a single timer_settime() with it_interval = period; the
+ *               kernel advances each period from the previous deadline
+ *               (what ptmr_sigev_signal -a does after aligning the first)
+ *   absolute  - re-arm a one-shot with TIMER_ABSTIME at the next grid
+ *               point after each expiration
+ */
+
+#define TIMER_SIG SIGRTMIN
+
+enum mode { MODE_RELATIVE, MODE_INTERVAL, MODE_ABSOLUTE };
+
+static const char *modeNames[] = { "relative", "interval", "absolute" };
+
+static uint64_t nowNs(void)
+{
+    struct timespec ts;
+
+    if (clock_gettime(CLOCK_MONOTONIC, &ts) == -1)
+        errExit("clock_gettime");
+    return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static void nsToTimespec(uint64_t ns, struct timespec *ts)
+{
+    ts->tv_sec = ns / 1000000000;
+    ts->tv_nsec = ns % 1000000000;
+}
+
+static void runMode(enum mode m, uint64_t period, long periods)
+{
+    struct itimerspec its;
+    struct sigevent sev;
+    uint64_t start, ideal, wake, late, sumLate = 0, maxLate = 0;
+    int64_t drift = 0;
+    sigset_t mask;
+    siginfo_t si;
+    timer_t tid;
+    long k, missed = 0;
+
+    sigemptyset(&mask);
+    sigaddset(&mask, TIMER_SIG);
+
+    sev.sigev_notify = SIGEV_SIGNAL;
+    sev.sigev_signo = TIMER_SIG;
+    sev.sigev_value.sival_ptr = &tid;
+    if (timer_create(CLOCK_MONOTONIC, &sev, &tid) == -1)
+        errExit("timer_create");
+
+    start = nowNs();
+    nsToTimespec(start + period, &its.it_value);
+    if (m == MODE_INTERVAL)
+        nsToTimespec(period, &its.it_interval);
+    else
+        nsToTimespec(0, &its.it_interval);
+    if (timer_settime(tid, TIMER_ABSTIME, &its, NULL) == -1)
+        errExit("timer_settime");
+
+    for (k = 1; k <= periods; k++) {
+        if (sigwaitinfo(&mask, &si) == -1)
+            errExit("sigwaitinfo");
+        wake = nowNs();
+
+        /* Expirations folded into an overrun still count as periods */
+        if (si.si_overrun > 0) {
+            missed += si.si_overrun;
+            k += si.si_overrun;
+        }
+
+        ideal = start + k * period;
+        late = wake > ideal ? wake - ideal : 0;
+        sumLate += late;
+        if (late > maxLate)
+            maxLate = late;
+        drift = (int64_t)(wake - ideal);
+
+        if (m == MODE_RELATIVE) {
+            nsToTimespec(period, &its.it_value);
+            if (timer_settime(tid, 0, &its, NULL) == -1)
+                errExit("timer_settime");
+        } else if (m == MODE_ABSOLUTE) {
+            /* Skip grid points that have already passed */
+            while (start + (k + 1) * period <= wake) {
+                k++;
+                missed++;
+            }
+            nsToTimespec(start + (k + 1) * period, &its.it_value);
+            if (timer_settime(tid, TIMER_ABSTIME, &its, NULL) == -1)
+                errExit("timer_settime");
+        }
+    }
+
+    if (timer_delete(tid) == -1)
+        errExit("timer_delete");
+
+    printf("%-9s %8ld %14.3f %14.3f %14.3f %8ld\n", modeNames[m], periods,
+           drift / 1000.0, (double)sumLate / periods / 1000.0,
+           maxLate / 1000.0, missed);
+}
+
+int main(int argc, char *argv[])
+{
+    uint64_t period = 1000000;  /* 1 ms */
+    long periods = 5000;
+    sigset_t mask;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "p:n:")) != -1) {
+        switch (opt) {
+        case 'p':
+            period = strtoull(optarg, NULL, 0);
+            break;
+        case 'n':
+            periods = atol(optarg);
+            break;
+        default:
+            usageErr("%s [-p period-nsecs] [-n periods]\n", argv[0]);
+        }
+    }
+
+    if (period == 0 || periods <= 0)
+        usageErr("%s [-p period-nsecs] [-n periods]\n", argv[0]);
+
+    /* Expirations are collected synchronously with sigwaitinfo() */
+    sigemptyset(&mask);
+    sigaddset(&mask, TIMER_SIG);
+    if (sigprocmask(SIG_BLOCK, &mask, NULL) == -1)
+        errExit("sigprocmask");
+
+    printf("Period: %llu ns\n", (unsigned long long)period);
+    printf("%-9s %8s %14s %14s %14s %8s\n", "mode", "periods",
+           "final-drift-us", "mean-late-us", "max-late-us", "missed");
+
+    runMode(MODE_RELATIVE, period, periods);
+    runMode(MODE_INTERVAL, period, periods);
+    runMode(MODE_ABSOLUTE, period, periods);
+
+    exit(EXIT_SUCCESS);
+}
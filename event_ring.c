@@ -0,0 +1,57 @@
+// event_ring.c
+#include <stdlib.h>
+#include "event_ring.h"
+
+int erInit(struct event_ring *r, unsigned long capacity)
+{
+    if (capacity == 0 || (capacity & (capacity - 1)) != 0)
+        return -1;
+
+    r->slots = calloc(capacity, sizeof(struct timer_event));
+    if (r->slots == NULL)
+        return -1;
+
+    r->mask = capacity - 1;
+    atomic_init(&r->head, 0);
+    atomic_init(&r->tail, 0);
+    atomic_init(&r->dropped, 0);
+    return 0;
+}
+
+int erPush(struct event_ring *r, const struct timer_event *ev)
+{
+    unsigned long head, tail;
+
+    head = atomic_load_explicit(&r->head, memory_order_relaxed);
+    tail = atomic_load_explicit(&r->tail, memory_order_acquire);
+
+    if (head - tail > r->mask) {
+        /* Only the producer writes this counter, so no RMW is needed */
+        atomic_store_explicit(&r->dropped,
+                atomic_load_explicit(&r->dropped, memory_order_relaxed) + 1,
+                memory_order_relaxed);
+        return -1;
+    }
+
+    r->slots[head & r->mask] = *ev;
+
+    /* Publish the slot contents before the new head */
+    atomic_store_explicit(&r->head, head + 1, memory_order_release);
+    return 0;
+}
+
+size_t erPop(struct event_ring *r, struct timer_event *out, size_t max)
+{
+    unsigned long head, tail;
+    size_t n;
+
+    tail = atomic_load_explicit(&r->tail, memory_order_relaxed);
+    head = atomic_load_explicit(&r->head, memory_order_acquire);
+
+    for (n = 0; n < max && tail != head; n++, tail++)
+        out[n] = r->slots[tail & r->mask];
+
+    /* Hand the slots back to the producer only after copying them */
+    atomic_store_explicit(&r->tail, tail, memory_order_release);
+    return n;
+}
@@ -0,0 +1,47 @@
+// event_ring.h
+#ifndef EVENT_RING_H
+#define EVENT_RING_H
+
+#include <signal.h>
+#include <stdatomic.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Preallocated single-producer/single-consumer ring of timer events.
+ *
+ * erPush() uses nothing but plain and atomic loads/stores on memory set up
+ * by erInit(), so it may be called from a signal handler. The consumer
+ * (normally a separate thread) drains records in batches with erPop().
+ */
+
+_Static_assert(ATOMIC_LONG_LOCK_FREE == 2,
+               "event ring needs lock-free atomics to be async-signal-safe");
+
+struct timer_event {
+    uint64_t timestamp;         /* CLOCK_MONOTONIC, in nanoseconds */
+    long timer_id;              /* Kernel timer ID, -1 if the timer is gone */
+    union sigval sival;         /* si_value of the expiration */
+    int overrun;                /* si_overrun of the expiration */
+};
+
+struct event_ring {
+    atomic_ulong head;          /* Next slot to write (producer only) */
+    char pad1[64 - sizeof(atomic_ulong)];
+    atomic_ulong tail;          /* Next slot to read (consumer only) */
+    char pad2[64 - sizeof(atomic_ulong)];
+    atomic_ulong dropped;       /* Events lost because the ring was full */
+    unsigned long mask;
+    struct timer_event *slots;
+};
+
+/* 'capacity' must be a power of two; returns -1 if allocation fails */
+int erInit(struct event_ring *r, unsigned long capacity);
+
+/* Async-signal-safe; returns 0, or -1 (and counts a drop) if full */
+int erPush(struct event_ring *r, const struct timer_event *ev);
+
+/* Copy up to 'max' events into 'out'; returns how many were copied */
+size_t erPop(struct event_ring *r, struct timer_event *out, size_t max);
+
+#endif
@@ -0,0 +1,142 @@
+// exp_trace.c
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include "exp_trace.h"
+
+_Static_assert(sizeof(struct et_file_header) <= ET_BLOCK_SIZE,
+               "file header must fit in the header page");
+
+int etCreate(struct exp_trace *et, const char *path, uint64_t bytes)
+{
+    void *map;
+    int fd;
+
+    memset(et, 0, sizeof(*et));
+    et->nblocks = bytes / ET_BLOCK_SIZE;
+    if (et->nblocks == 0)
+        et->nblocks = 1;
+    et->mapLen = (et->nblocks + 1) * ET_BLOCK_SIZE;
+
+    fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd == -1)
+        return -1;
+    if (ftruncate(fd, et->mapLen) == -1) {
+        close(fd);
+        return -1;
+    }
+
+    map = mmap(NULL, et->mapLen, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED)
+        return -1;
+
+    /* The file is sparse and zero-filled: every block has seq 0 */
+    et->hdr = map;
+    et->blocks = (unsigned char *)map + ET_BLOCK_SIZE;
+    memcpy(et->hdr->magic, ET_MAGIC, sizeof(et->hdr->magic));
+    et->hdr->version = ET_VERSION;
+    et->hdr->blockSize = ET_BLOCK_SIZE;
+    et->hdr->nblocks = et->nblocks;
+    return 0;
+}
+
+int etClose(struct exp_trace *et)
+{
+    int s = 0;
+
+    if (et->hdr == NULL)
+        return 0;
+    if (msync(et->hdr, et->mapLen, MS_SYNC) == -1)
+        s = -1;
+    if (munmap(et->hdr, et->mapLen) == -1)
+        s = -1;
+    et->hdr = NULL;
+    return s;
+}
+
+static unsigned char *etPutVarint(unsigned char *p, uint64_t v)
+{
+    while (v >= 0x80) {
+        *p++ = (unsigned char)v | 0x80;
+        v >>= 7;
+    }
+    *p++ = (unsigned char)v;
+    return p;
+}
+
+static const unsigned char *etGetVarint(const unsigned char *p,
+                                        const unsigned char *end, uint64_t *v)
+{
+    int shift;
+
+    *v = 0;
+    for (shift = 0; p < end && shift < 64; shift += 7) {
+        *v |= (uint64_t)(*p & 0x7f) << shift;
+        if (!(*p++ & 0x80))
+            return p;
+    }
+    return NULL;
+}
+
+/* Start the next block in the ring, overwriting the oldest */
+static void etNextBlock(struct exp_trace *et, uint64_t base)
+{
+    uint64_t seq = et->hdr->seq + 1;
+    struct et_block_header *b;
+
+    b = (struct et_block_header *)(et->blocks +
+                                   ((seq - 1) % et->nblocks) * ET_BLOCK_SIZE);
+    b->seq = 0;                 /* Readers skip it until it is consistent */
+    b->used = 0;
+    b->count = 0;
+    b->base = base;
+    __atomic_store_n(&b->seq, seq, __ATOMIC_RELEASE);
+
+    et->hdr->seq = seq;
+    et->cur = b;
+    et->prev = base;
+}
+
+void etAppend(struct exp_trace *et, uint32_t id, uint64_t scheduled,
+              uint64_t delivered, uint64_t overrun)
+{
+    unsigned char rec[ET_RECORD_MAX], *p;
+    int64_t late;
+    size_t len;
+
+    /* Delivered times only move forward within a block */
+    if (et->cur == NULL || delivered < et->prev ||
+            et->cur->used + ET_RECORD_MAX > ET_PAYLOAD)
+        etNextBlock(et, delivered);
+
+    late = (int64_t)(delivered - scheduled);
+    p = etPutVarint(rec, id);
+    p = etPutVarint(p, delivered - et->prev);
+    p = etPutVarint(p, ((uint64_t)late << 1) ^ (uint64_t)(late >> 63));
+    p = etPutVarint(p, overrun);
+    len = p - rec;
+
+    memcpy((unsigned char *)(et->cur + 1) + et->cur->used, rec, len);
+    et->cur->count++;
+    __atomic_store_n(&et->cur->used, et->cur->used + len, __ATOMIC_RELEASE);
+    et->prev = delivered;
+}
+
+const unsigned char *etDecode(const unsigned char *p, const unsigned char *end,
+                              uint64_t prev, struct et_record *rec)
+{
+    uint64_t id, delta, zz;
+
+    if ((p = etGetVarint(p, end, &id)) == NULL ||
+            (p = etGetVarint(p, end, &delta)) == NULL ||
+            (p = etGetVarint(p, end, &zz)) == NULL ||
+            (p = etGetVarint(p, end, &rec->overrun)) == NULL)
+        return NULL;
+
+    rec->id = id;
+    rec->delivered = prev + delta;
+    rec->scheduled = rec->delivered - (int64_t)((zz >> 1) ^ -(zz & 1));
+    return p;
+}
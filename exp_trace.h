@@ -0,0 +1,76 @@
+// exp_trace.h
+#ifndef EXP_TRACE_H
+#define EXP_TRACE_H
+
+#include <stdint.h>
+
+/*
+ * Binary expiration trace in a memory-mapped ring file.
+ *
+ * Each record is {spec id, scheduled ns, delivered ns, overrun}, encoded
+ * as LEB128 varints: the spec id (the timer's command-line or -f index),
+ * the delivered time as a delta from the previous record, the lateness
+ * (delivered - scheduled, zigzag encoded because a coalesced or early
+ * timer may be negative) and the overrun. A typical record takes 5-8
+ * bytes instead of ~80 of text.
+ *
+ * The file is a header page followed by ET_BLOCK_SIZE blocks used as a
+ * ring. Deltas restart in every block (from the block's base time), so
+ * when the writer wraps and overwrites the oldest block the rest stay
+ * decodable. etAppend() only stores to the mapping -- no syscalls, no
+ * allocation -- so it is async-signal-safe and sustains millions of
+ * records per second, but it must not be called concurrently.
+ */
+
+#define ET_MAGIC      "PTMRTRC1"
+#define ET_VERSION    1
+#define ET_BLOCK_SIZE 4096
+#define ET_RECORD_MAX 35        /* 5 + 3 * 10 varint bytes */
+
+struct et_file_header {
+    char magic[8];
+    uint32_t version;
+    uint32_t blockSize;
+    uint64_t nblocks;
+    uint64_t seq;               /* Most recently started block */
+};
+
+struct et_block_header {
+    uint64_t seq;               /* 1, 2, ...; 0 while (re)initialised */
+    uint64_t base;              /* First record's delivered-ns delta base */
+    uint32_t used;              /* Payload bytes after this header */
+    uint32_t count;             /* Records in the payload */
+};
+
+#define ET_PAYLOAD (ET_BLOCK_SIZE - sizeof(struct et_block_header))
+
+struct exp_trace {
+    struct et_file_header *hdr;
+    unsigned char *blocks;
+    uint64_t nblocks;
+    size_t mapLen;
+    struct et_block_header *cur;    /* Block being filled (NULL: none) */
+    uint64_t prev;                  /* Last delivered ns in 'cur' */
+};
+
+struct et_record {
+    uint32_t id;                /* Timer spec, 1-based */
+    uint64_t scheduled;
+    uint64_t delivered;
+    uint64_t overrun;
+};
+
+/* Create (truncate) 'path' with room for 'bytes' of blocks; -1 on error */
+int etCreate(struct exp_trace *et, const char *path, uint64_t bytes);
+int etClose(struct exp_trace *et);
+
+/* Async-signal-safe; single writer */
+void etAppend(struct exp_trace *et, uint32_t id, uint64_t scheduled,
+              uint64_t delivered, uint64_t overrun);
+
+/* Decoding: read one record at 'p' (at most 'end'), given the previous
+   delivered time; returns the byte after it, or NULL if truncated */
+const unsigned char *etDecode(const unsigned char *p, const unsigned char *end,
+                              uint64_t prev, struct et_record *rec);
+
+#endif
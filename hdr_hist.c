@@ -0,0 +1,89 @@
+// hdr_hist.c
+#include <string.h>
+#include "hdr_hist.h"
+
+#define HH_MAX_VALUE (((uint64_t)1 << HH_MAX_BITS) - 1)
+
+int hhIndex(uint64_t value)
+{
+    int shift;
+
+    if (value > HH_MAX_VALUE)
+        value = HH_MAX_VALUE;
+    if (value < 2 * HH_SUB_BUCKETS)
+        return (int)value;
+
+    /* Keep the HH_SUB_BITS + 1 most significant bits of the value */
+    shift = (63 - __builtin_clzll(value)) - HH_SUB_BITS;
+    return shift * HH_SUB_BUCKETS + (int)(value >> shift);
+}
+
+/* Largest value that maps to bucket 'idx' */
+static uint64_t hhBucketTop(int idx)
+{
+    int shift;
+
+    if (idx < 2 * HH_SUB_BUCKETS)
+        return idx;
+
+    shift = idx / HH_SUB_BUCKETS - 1;
+    return (((uint64_t)(idx - shift * HH_SUB_BUCKETS) + 1) << shift) - 1;
+}
+
+void hhInit(struct hdr_hist *h)
+{
+    memset(h, 0, sizeof(*h));
+    h->min = UINT64_MAX;
+}
+
+void hhRecord(struct hdr_hist *h, uint64_t value)
+{
+    h->counts[hhIndex(value)]++;
+    h->count++;
+    h->sum += value;
+    if (value < h->min)
+        h->min = value;
+    if (value > h->max)
+        h->max = value;
+}
+
+void hhMerge(struct hdr_hist *dst, const struct hdr_hist *src)
+{
+    int i;
+
+    for (i = 0; i < HH_BUCKETS; i++)
+        dst->counts[i] += src->counts[i];
+    dst->count += src->count;
+    dst->sum += src->sum;
+    if (src->min < dst->min)
+        dst->min = src->min;
+    if (src->max > dst->max)
+        dst->max = src->max;
+}
+
+uint64_t hhPercentile(const struct hdr_hist *h, double pct)
+{
+    uint64_t target, seen = 0, top;
+    int i;
+
+    if (h->count == 0)
+        return 0;
+
+    target = (uint64_t)(pct / 100.0 * h->count + 0.5);
+    if (target < 1)
+        target = 1;
+
+    for (i = 0; i < HH_BUCKETS; i++) {
+        seen += h->counts[i];
+        if (seen >= target) {
+            top = hhBucketTop(i);
+            return top < h->max ? top : h->max;
+        }
+    }
+    return h->max;
+}
+
+double hhMean(const struct hdr_hist *h)
+{
+    return h->count ? (double)h->sum / h->count : 0.0;
+}
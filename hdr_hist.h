@@ -0,0 +1,44 @@
+// hdr_hist.h
+#ifndef HDR_HIST_H
+#define HDR_HIST_H
+
+#include <stdint.h>
+
+/*
+ * High-dynamic-range histogram of 64-bit values (e.g. nanoseconds).
+ *
+ * Buckets are log-linear: every power-of-two range is split into
+ * HH_SUB_BUCKETS equal sub-buckets, so any recorded value is reported
+ * with a relative error below 1 / HH_SUB_BUCKETS (< 0.8%) from 1 ns up
+ * to 2^HH_MAX_BITS ns (about 4.9 hours). Larger values are clamped.
+ * Recording is a few arithmetic operations and one increment, with no
+ * allocation, so it may be done from a signal handler.
+ */
+
+#define HH_SUB_BITS    7
+#define HH_SUB_BUCKETS (1 << HH_SUB_BITS)
+#define HH_MAX_BITS    44
+#define HH_BUCKETS     ((HH_MAX_BITS - HH_SUB_BITS) * HH_SUB_BUCKETS + HH_SUB_BUCKETS)
+
+struct hdr_hist {
+    uint64_t count;
+    uint64_t min;
+    uint64_t max;
+    uint64_t sum;
+    uint64_t counts[HH_BUCKETS];
+};
+
+void hhInit(struct hdr_hist *h);
+void hhRecord(struct hdr_hist *h, uint64_t value);
+void hhMerge(struct hdr_hist *dst, const struct hdr_hist *src);
+
+/* Bucket that 'value' is counted in, for callers that keep their own
+   (e.g. atomic) copy of counts[] */
+int hhIndex(uint64_t value);
+
+/* Smallest value v such that 'pct' percent of samples are <= v, reported
+   as the upper edge of its bucket (0 if the histogram is empty) */
+uint64_t hhPercentile(const struct hdr_hist *h, double pct);
+double hhMean(const struct hdr_hist *h);
+
+#endif
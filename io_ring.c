@@ -0,0 +1,110 @@
+// io_ring.c
+#include <errno.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include "io_ring.h"
+
+int irInit(struct io_ring *r, unsigned entries)
+{
+    struct io_uring_params p;
+    size_t sqLen, cqLen;
+    char *sq, *cq;
+
+    memset(&p, 0, sizeof(p));
+    r->fd = syscall(__NR_io_uring_setup, entries, &p);
+    if (r->fd == -1)
+        return -1;
+
+    sqLen = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+    cqLen = p.cq_off.cqes + p.cq_entries * sizeof(struct io_uring_cqe);
+
+    /* Newer kernels map both rings with a single mmap() */
+    if (p.features & IORING_FEAT_SINGLE_MMAP) {
+        if (cqLen > sqLen)
+            sqLen = cqLen;
+        cqLen = sqLen;
+    }
+
+    sq = mmap(NULL, sqLen, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+              r->fd, IORING_OFF_SQ_RING);
+    if (sq == MAP_FAILED)
+        return -1;
+
+    if (p.features & IORING_FEAT_SINGLE_MMAP) {
+        cq = sq;
+    } else {
+        cq = mmap(NULL, cqLen, PROT_READ | PROT_WRITE,
+                  MAP_SHARED | MAP_POPULATE, r->fd, IORING_OFF_CQ_RING);
+        if (cq == MAP_FAILED)
+            return -1;
+    }
+
+    r->sqes = mmap(NULL, p.sq_entries * sizeof(struct io_uring_sqe),
+                   PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                   r->fd, IORING_OFF_SQES);
+    if (r->sqes == MAP_FAILED)
+        return -1;
+
+    r->sqHead = (unsigned *)(sq + p.sq_off.head);
+    r->sqTail = (unsigned *)(sq + p.sq_off.tail);
+    r->sqMask = (unsigned *)(sq + p.sq_off.ring_mask);
+    r->sqArray = (unsigned *)(sq + p.sq_off.array);
+    r->sqPending = 0;
+
+    r->cqHead = (unsigned *)(cq + p.cq_off.head);
+    r->cqTail = (unsigned *)(cq + p.cq_off.tail);
+    r->cqMask = (unsigned *)(cq + p.cq_off.ring_mask);
+    r->cqes = (struct io_uring_cqe *)(cq + p.cq_off.cqes);
+    return 0;
+}
+
+struct io_uring_sqe *irGetSqe(struct io_ring *r)
+{
+    unsigned head, tail, idx;
+    struct io_uring_sqe *sqe;
+
+    head = __atomic_load_n(r->sqHead, __ATOMIC_ACQUIRE);
+    tail = *r->sqTail + r->sqPending;
+    if (tail - head > *r->sqMask)
+        return NULL;
+
+    idx = tail & *r->sqMask;
+    sqe = &r->sqes[idx];
+    memset(sqe, 0, sizeof(*sqe));
+    r->sqArray[idx] = idx;
+    r->sqPending++;
+    return sqe;
+}
+
+int irSubmitAndWait(struct io_ring *r, unsigned waitNr)
+{
+    unsigned submit = r->sqPending;
+    int ret;
+
+    /* Make the filled SQEs visible before the kernel sees the new tail */
+    __atomic_store_n(r->sqTail, *r->sqTail + submit, __ATOMIC_RELEASE);
+    r->sqPending = 0;
+
+    do {
+        ret = syscall(__NR_io_uring_enter, r->fd, submit, waitNr,
+                      waitNr ? IORING_ENTER_GETEVENTS : 0, NULL, 0);
+    } while (ret == -1 && errno == EINTR);
+
+    return ret;
+}
+
+struct io_uring_cqe *irPeekCqe(struct io_ring *r)
+{
+    unsigned head = *r->cqHead;
+
+    if (head == __atomic_load_n(r->cqTail, __ATOMIC_ACQUIRE))
+        return NULL;
+    return &r->cqes[head & *r->cqMask];
+}
+
+void irCqeSeen(struct io_ring *r)
+{
+    __atomic_store_n(r->cqHead, *r->cqHead + 1, __ATOMIC_RELEASE);
+}
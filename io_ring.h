@@ -0,0 +1,43 @@
+// io_ring.h
+#ifndef IO_RING_H
+#define IO_RING_H
+
+#include <linux/io_uring.h>
+
+/*
+ * Minimal io_uring wrapper on top of the raw system calls (no liburing):
+ * just enough to queue SQEs, submit them and harvest CQEs.
+ */
+
+struct io_ring {
+    int fd;
+
+    /* Submission queue (shared with the kernel) */
+    unsigned *sqHead;
+    unsigned *sqTail;
+    unsigned *sqMask;
+    unsigned *sqArray;
+    struct io_uring_sqe *sqes;
+    unsigned sqPending;         /* SQEs queued since the last submit */
+
+    /* Completion queue (shared with the kernel) */
+    unsigned *cqHead;
+    unsigned *cqTail;
+    unsigned *cqMask;
+    struct io_uring_cqe *cqes;
+};
+
+/* Returns -1 (with errno set) if the ring cannot be set up */
+int irInit(struct io_ring *r, unsigned entries);
+
+/* Next free SQE (zeroed), or NULL if the submission queue is full */
+struct io_uring_sqe *irGetSqe(struct io_ring *r);
+
+/* Submit queued SQEs and wait for at least 'waitNr' completions */
+int irSubmitAndWait(struct io_ring *r, unsigned waitNr);
+
+/* Oldest unseen CQE, or NULL; release it with irCqeSeen() */
+struct io_uring_cqe *irPeekCqe(struct io_ring *r);
+void irCqeSeen(struct io_ring *r);
+
+#endif
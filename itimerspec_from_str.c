@@ -2,7 +2,12 @@
 #include "itimerspec_from_str.h"
 
 void itimerspecFromStr(char *str, struct itimerspec *tsp) {
-    char *cptr, *sptr;
+    char *cptr, *sptr, *tptr;
+
+    // Drop any '~' slack suffix (see itimerspecSlackFromStr())
+    tptr = strchr(str, '~');
+    if (tptr != NULL)
+        *tptr = '\0';
 
     // Locate the ':' separator (if any)
     cptr = strchr(str, ':');
@@ -32,3 +37,24 @@ void itimerspecFromStr(char *str, struct itimerspec *tsp) {
     }
 }
 
+
+void itimerspecSlackFromStr(char *str, struct itimerspec *tsp,
+                            struct timespec *slack) {
+    char *tptr, *sptr;
+
+    // Locate the '~' separator (if any) and parse the slack after it
+    tptr = strchr(str, '~');
+    if (tptr == NULL) {
+        slack->tv_sec = 0;
+        slack->tv_nsec = 0;
+    } else {
+        *tptr = '\0';  // Null-terminate the timer spec part
+        sptr = strchr(tptr + 1, '/');
+        if (sptr != NULL)
+            *sptr = '\0';
+        slack->tv_sec = atoi(tptr + 1);
+        slack->tv_nsec = (sptr != NULL) ? atoi(sptr + 1) : 0;
+    }
+
+    itimerspecFromStr(str, tsp);
+}
@@ -9,5 +9,10 @@
 
 void itimerspecFromStr(char *str, struct itimerspec *tsp);
 
+// Same as itimerspecFromStr(), plus an optional "~slack-secs[/slack-nsecs]"
+// suffix giving how late each expiration may be delivered (default: 0)
+void itimerspecSlackFromStr(char *str, struct itimerspec *tsp,
+                            struct timespec *slack);
+
 #endif
 
@@ -0,0 +1,124 @@
+#define _GNU_SOURCE
+#include <time.h>
+#include "hdr_hist.h"       /* Latency histograms */
+#include "notify_mech.h"    /* Identical workload per mechanism */
+#include "tlpi_hdr.h"       /* Error handling functions */
+
+/*
+ * Arms a population of periodic timers with absolute deadlines and
+ * records, for every notification, how late it arrived (nanoseconds
+ * against CLOCK_MONOTONIC) into a high-dynamic-range histogram. One row
+ * is printed per notification mechanism and per timer clock.
+ */
+
+#define USAGE "%s [-n timers] [-e expirations-per-timer] [-i interval-nsecs] [-m mechanism]... [-c realtime|monotonic|boottime]...\n"
+
+struct clock_name {
+    const char *name;
+    clockid_t id;
+};
+
+static const struct clock_name clocks[] = {
+    { "realtime", CLOCK_REALTIME },
+    { "monotonic", CLOCK_MONOTONIC },
+    { "boottime", CLOCK_BOOTTIME },
+};
+
+#define NCLOCKS (sizeof(clocks) / sizeof(clocks[0]))
+
+int main(int argc, char *argv[])
+{
+    static struct hdr_hist hist;
+    struct nm_run run;
+    int mechs[NM_COUNT], clockSel[NCLOCKS];
+    int nmechs = 0, nclocks = 0, ntimers = 1000, perTimer = 10;
+    uint64_t interval = 10000000;       /* 10 ms */
+    int opt, m, c, k;
+
+    while ((opt = getopt(argc, argv, "n:e:i:m:c:")) != -1) {
+        switch (opt) {
+        case 'n':
+            ntimers = atoi(optarg);
+            break;
+        case 'e':
+            perTimer = atoi(optarg);
+            break;
+        case 'i':
+            interval = strtoull(optarg, NULL, 0);
+            break;
+        case 'm':
+            m = nmLookup(optarg);
+            if (m == -1)
+                usageErr("%s: unknown mechanism '%s'\n", argv[0], optarg);
+            if (nmechs == NM_COUNT)
+                usageErr("%s: too many mechanisms (at most %d)\n", argv[0],
+                         NM_COUNT);
+            mechs[nmechs++] = m;
+            break;
+        case 'c':
+            for (c = 0; c < (int)NCLOCKS; c++)
+                if (strcmp(optarg, clocks[c].name) == 0)
+                    break;
+            if (c == NCLOCKS)
+                usageErr("%s: unknown clock '%s'\n", argv[0], optarg);
+            if (nclocks == NCLOCKS)
+                usageErr("%s: too many clocks (at most %d)\n", argv[0],
+                         (int)NCLOCKS);
+            clockSel[nclocks++] = c;
+            break;
+        default:
+            usageErr(USAGE, argv[0]);
+        }
+    }
+
+    if (ntimers <= 0 || perTimer <= 0 || interval == 0)
+        usageErr(USAGE, argv[0]);
+
+    /* Default: every mechanism on REALTIME and MONOTONIC */
+    if (nmechs == 0)
+        for (m = 0; m < NM_COUNT; m++)
+            mechs[nmechs++] = m;
+    if (nclocks == 0) {
+        clockSel[nclocks++] = 0;
+        clockSel[nclocks++] = 1;
+    }
+
+    printf("%d timers, %d expirations each, interval %llu ns\n",
+           ntimers, perTimer, (unsigned long long)interval);
+    printf("%-12s %-10s %9s %9s %10s %10s %10s %10s %9s\n", "mechanism",
+           "clock", "samples", "overruns", "p50-ns", "p99-ns", "p99.9-ns",
+           "max-ns", "mean-ns");
+
+    for (m = 0; m < nmechs; m++) {
+        for (c = 0; c < nclocks; c++) {
+            k = clockSel[c];
+            hhInit(&hist);
+
+            memset(&run, 0, sizeof(run));
+            run.mech = mechs[m];
+            run.clock = clocks[k].id;
+            run.ntimers = ntimers;
+            run.first = 50000000;                   /* 50 ms to settle */
+            run.stagger = interval / ntimers;       /* Spread the phases */
+            run.interval = interval;
+            run.expirations = (uint64_t)ntimers * perTimer;
+            run.record = nmRecordLateness;
+            run.arg = &hist;
+
+            if (nmRun(&run) == -1)
+                errExit(nmNames[mechs[m]]);
+
+            printf("%-12s %-10s %9llu %9llu %10llu %10llu %10llu %10llu %9.0f\n",
+                   nmNames[mechs[m]], clocks[k].name,
+                   (unsigned long long)hist.count,
+                   (unsigned long long)run.overruns,
+                   (unsigned long long)hhPercentile(&hist, 50),
+                   (unsigned long long)hhPercentile(&hist, 99),
+                   (unsigned long long)hhPercentile(&hist, 99.9),
+                   (unsigned long long)hist.max, hhMean(&hist));
+            fflush(stdout);
+        }
+    }
+
+    exit(EXIT_SUCCESS);
+}
@@ -0,0 +1,113 @@
+// metrics_shm.c
+#define _GNU_SOURCE
+#include <errno.h>
+#include <fcntl.h>
+#include <sched.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "metrics_shm.h"
+
+_Static_assert(ATOMIC_INT_LOCK_FREE == 2,
+               "a process-shared sequence lock needs lock-free atomics");
+
+void msName(char *name, size_t len, pid_t pid)
+{
+    snprintf(name, len, "/ptmr-%ld", (long)pid);
+}
+
+struct ms_segment *msCreate(const char *name)
+{
+    struct ms_segment *seg;
+    int fd;
+
+    fd = shm_open(name, O_CREAT | O_TRUNC | O_RDWR, S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
+    if (fd == -1)
+        return NULL;
+
+    if (ftruncate(fd, sizeof(struct ms_segment)) == -1) {
+        close(fd);
+        return NULL;
+    }
+
+    seg = mmap(NULL, sizeof(struct ms_segment), PROT_READ | PROT_WRITE,
+               MAP_SHARED, fd, 0);
+    close(fd);
+    if (seg == MAP_FAILED)
+        return NULL;
+
+    /* ftruncate() zero-filled it; readers check magic last */
+    seg->version = MS_VERSION;
+    atomic_init(&seg->seq, 0);
+    atomic_thread_fence(memory_order_release);
+    seg->magic = MS_MAGIC;
+    return seg;
+}
+
+void msPublish(struct ms_segment *seg, const struct ms_snapshot *snap)
+{
+    unsigned s = atomic_load_explicit(&seg->seq, memory_order_relaxed);
+
+    atomic_store_explicit(&seg->seq, s + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);      /* Odd before data */
+    memcpy(&seg->snap, snap, sizeof(*snap));
+    atomic_store_explicit(&seg->seq, s + 2, memory_order_release);
+}
+
+const struct ms_segment *msAttach(const char *name)
+{
+    struct ms_segment *seg;
+    struct stat sb;
+    int fd;
+
+    fd = shm_open(name, O_RDONLY, 0);
+    if (fd == -1)
+        return NULL;
+
+    if (fstat(fd, &sb) == -1) {
+        close(fd);
+        return NULL;
+    }
+    if (sb.st_size < (off_t)sizeof(struct ms_segment)) {
+        close(fd);
+        errno = EPROTO;
+        return NULL;
+    }
+
+    seg = mmap(NULL, sizeof(struct ms_segment), PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (seg == MAP_FAILED)
+        return NULL;
+
+    if (seg->magic != MS_MAGIC || seg->version != MS_VERSION) {
+        munmap(seg, sizeof(struct ms_segment));
+        errno = EPROTO;
+        return NULL;
+    }
+    return seg;
+}
+
+void msRead(const struct ms_segment *seg, struct ms_snapshot *snap)
+{
+    unsigned s1, s2;
+
+    for (;;) {
+        s1 = atomic_load_explicit((atomic_uint *)&seg->seq, memory_order_acquire);
+        if (s1 & 1) {
+            sched_yield();              /* Writer is mid-copy */
+            continue;
+        }
+        memcpy(snap, (const void *)&seg->snap, sizeof(*snap));
+        atomic_thread_fence(memory_order_acquire);  /* Data before recheck */
+        s2 = atomic_load_explicit((atomic_uint *)&seg->seq, memory_order_relaxed);
+        if (s1 == s2)
+            return;
+    }
+}
+
+void msDetach(const struct ms_segment *seg)
+{
+    munmap((void *)seg, sizeof(struct ms_segment));
+}
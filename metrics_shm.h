@@ -0,0 +1,64 @@
+// metrics_shm.h
+#ifndef METRICS_SHM_H
+#define METRICS_SHM_H
+
+#include <stdatomic.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+/*
+ * Live metrics of a running timer process, published in a POSIX shared
+ * memory object ("/ptmr-<pid>") for viewers such as ptmr_top.
+ *
+ * The segment holds one snapshot guarded by a sequence lock: the single
+ * writer makes the sequence odd, copies the snapshot in and makes it even
+ * again; readers copy the snapshot out and retry if the sequence was odd
+ * or changed meanwhile. Readers map the segment read-only and never make
+ * the writer wait, and the writer is a separate publishing thread, so the
+ * timer hot path is untouched.
+ */
+
+#define MS_MAGIC   0x706d7472   /* "ptmr" */
+#define MS_VERSION 1
+#define MS_NAME_MAX 32
+
+struct ms_snapshot {
+    char backend[16];
+    int32_t pid;
+    uint32_t period;            /* Publishing period, ms */
+    uint64_t updated;           /* CLOCK_MONOTONIC ns of this snapshot */
+    uint64_t activeTimers;      /* Armed (periodic or pending) timers */
+    uint64_t expirations;       /* Notifications since start */
+    uint64_t overruns;          /* Expirations folded into overruns */
+    double expirationsPerSec;   /* Over the last period, incl. overruns */
+    uint64_t queueDepth;        /* Expirations waiting to be dispatched */
+    uint64_t latencySamples;    /* Dispatch latency over the last period */
+    uint64_t latencyP50;        /* ... in ns past each deadline */
+    uint64_t latencyP99;
+    uint64_t latencyP999;
+    uint64_t latencyMax;
+};
+
+struct ms_segment {
+    uint32_t magic;
+    uint32_t version;
+    atomic_uint seq;            /* Odd while the writer is copying */
+    char pad[64 - 3 * sizeof(uint32_t)];
+    struct ms_snapshot snap;
+};
+
+/* Shared memory object name for process 'pid' */
+void msName(char *name, size_t len, pid_t pid);
+
+/* Writer: create (or replace) and map the segment; NULL on error */
+struct ms_segment *msCreate(const char *name);
+void msPublish(struct ms_segment *seg, const struct ms_snapshot *snap);
+
+/* Reader: map an existing segment read-only; NULL on error (EPROTO if it
+   is not a segment of this version) */
+const struct ms_segment *msAttach(const char *name);
+void msRead(const struct ms_segment *seg, struct ms_snapshot *snap);
+
+void msDetach(const struct ms_segment *seg);
+
+#endif
@@ -0,0 +1,140 @@
+#define _GNU_SOURCE
+#include <time.h>
+#include "hdr_hist.h"       /* Latency histograms */
+#include "notify_mech.h"    /* Identical workload per mechanism */
+#include "tlpi_hdr.h"       /* Error handling functions */
+
+/*
+ * Notification mechanism shootout. For every mechanism in notify_mech.c
+ * the same two workloads are run on CLOCK_MONOTONIC:
+ *
+ *   latency    - a light load (default 100 timers every 10 ms); records
+ *                expiration-to-callback latency percentiles
+ *   throughput - 1000 timers whose combined rate doubles each step until
+ *                the mechanism no longer keeps up (fewer than 99% of
+ *                expirations delivered individually, or under 95% of the
+ *                target rate achieved); reports the best sustained rate
+ *
+ * Output is CSV on stdout, one row per mechanism.
+ */
+
+#define USAGE "%s [-n latency-timers] [-i latency-interval-nsecs] [-d step-msecs] [-r max-rate] [-m mechanism]...\n"
+
+#define RATE_TIMERS 1000        /* Timers sharing the throughput load */
+#define RATE_START  1000        /* First throughput step, expirations/s */
+
+static void runLatency(enum nm_mech mech, int ntimers, uint64_t interval,
+                       struct hdr_hist *hist)
+{
+    struct nm_run run;
+
+    hhInit(hist);
+    memset(&run, 0, sizeof(run));
+    run.mech = mech;
+    run.clock = CLOCK_MONOTONIC;
+    run.ntimers = ntimers;
+    run.first = 20000000;
+    run.stagger = interval / ntimers;
+    run.interval = interval;
+    run.expirations = (uint64_t)ntimers * 20;
+    run.record = nmRecordLateness;
+    run.arg = hist;
+
+    if (nmRun(&run) == -1)
+        errExit(nmNames[mech]);
+}
+
+/* Highest sustained expirations/s, doubling the offered rate each step */
+static double runThroughput(enum nm_mech mech, uint64_t stepNs,
+                            double maxRate)
+{
+    struct nm_run run;
+    double rate, achieved, best = 0.0;
+    uint64_t interval;
+
+    for (rate = RATE_START; rate <= maxRate; rate *= 2) {
+        interval = (uint64_t)(RATE_TIMERS * 1e9 / rate);
+
+        memset(&run, 0, sizeof(run));
+        run.mech = mech;
+        run.clock = CLOCK_MONOTONIC;
+        run.ntimers = RATE_TIMERS;
+        run.first = 20000000;
+        run.stagger = interval / RATE_TIMERS;
+        run.interval = interval;
+        run.expirations = (uint64_t)(rate * stepNs / 1e9);
+        if (run.expirations < RATE_TIMERS)
+            run.expirations = RATE_TIMERS;
+
+        if (nmRun(&run) == -1)
+            errExit(nmNames[mech]);
+
+        achieved = run.elapsed ? run.delivered * 1e9 / run.elapsed : 0.0;
+        if (run.delivered < 0.99 * (run.delivered + run.overruns) ||
+                achieved < 0.95 * rate)
+            break;
+        best = achieved;
+    }
+
+    return best;
+}
+
+int main(int argc, char *argv[])
+{
+    static struct hdr_hist hist;
+    int mechs[NM_COUNT], nmechs = 0, ntimers = 100, opt, m;
+    uint64_t interval = 10000000, stepNs = 500000000;
+    double maxRate = 1024000, rate;
+
+    while ((opt = getopt(argc, argv, "n:i:d:r:m:")) != -1) {
+        switch (opt) {
+        case 'n':
+            ntimers = atoi(optarg);
+            break;
+        case 'i':
+            interval = strtoull(optarg, NULL, 0);
+            break;
+        case 'd':
+            stepNs = strtoull(optarg, NULL, 0) * 1000000;
+            break;
+        case 'r':
+            maxRate = atof(optarg);
+            break;
+        case 'm':
+            m = nmLookup(optarg);
+            if (m == -1)
+                usageErr("%s: unknown mechanism '%s'\n", argv[0], optarg);
+            if (nmechs == NM_COUNT)
+                usageErr("%s: too many mechanisms (at most %d)\n", argv[0],
+                         NM_COUNT);
+            mechs[nmechs++] = m;
+            break;
+        default:
+            usageErr(USAGE, argv[0]);
+        }
+    }
+
+    if (ntimers <= 0 || interval == 0 || stepNs == 0)
+        usageErr(USAGE, argv[0]);
+
+    if (nmechs == 0)
+        for (m = 0; m < NM_COUNT; m++)
+            mechs[nmechs++] = m;
+
+    printf("mechanism,samples,p50_ns,p99_ns,p99.9_ns,max_ns,mean_ns,max_rate_per_s\n");
+
+    for (m = 0; m < nmechs; m++) {
+        runLatency(mechs[m], ntimers, interval, &hist);
+        rate = runThroughput(mechs[m], stepNs, maxRate);
+
+        printf("%s,%llu,%llu,%llu,%llu,%llu,%.0f,%.0f\n", nmNames[mechs[m]],
+               (unsigned long long)hist.count,
+               (unsigned long long)hhPercentile(&hist, 50),
+               (unsigned long long)hhPercentile(&hist, 99),
+               (unsigned long long)hhPercentile(&hist, 99.9),
+               (unsigned long long)hist.max, hhMean(&hist), rate);
+        fflush(stdout);
+    }
+
+    exit(EXIT_SUCCESS);
+}
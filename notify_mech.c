@@ -0,0 +1,371 @@
+// notify_mech.c
+#define _GNU_SOURCE
+#include <errno.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/signalfd.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+#include "hdr_hist.h"
+#include "notify_mech.h"
+
+#define NM_BATCH     64         /* Records per signalfd/epoll batch */
+#define NM_IDX_BITS  20         /* sival_int = run generation | index */
+#define NM_IDX_MASK  ((1 << NM_IDX_BITS) - 1)
+
+const char *nmNames[NM_COUNT] = {
+    "sigusr1", "sigrt", "sigwaitinfo", "signalfd", "timerfd", "thread"
+};
+
+/* State of the run in progress (one at a time) */
+static struct {
+    struct nm_run *run;
+    uint64_t *next;             /* Next expected deadline, monotonic ns */
+    timer_t *tids;
+    int *fds;
+    int gen;                    /* Tags sival_int to reject stale signals */
+    uint64_t accounted;
+    uint64_t lastDelivery;
+    volatile sig_atomic_t done;
+    int active;                 /* SIGEV_THREAD: callbacks may proceed */
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+} st = { .lock = PTHREAD_MUTEX_INITIALIZER, .cond = PTHREAD_COND_INITIALIZER };
+
+int nmLookup(const char *name)
+{
+    int m;
+
+    for (m = 0; m < NM_COUNT; m++)
+        if (strcmp(name, nmNames[m]) == 0)
+            return m;
+    return -1;
+}
+
+void nmRecordLateness(void *arg, int timer, uint64_t lateness,
+                      unsigned overrun)
+{
+    hhRecord(arg, lateness);
+}
+
+static uint64_t nmNow(clockid_t clock)
+{
+    struct timespec ts;
+
+    clock_gettime(clock, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static void nmNsToTimespec(uint64_t ns, struct timespec *ts)
+{
+    ts->tv_sec = ns / 1000000000;
+    ts->tv_nsec = ns % 1000000000;
+}
+
+/* Account one notification for timer 'idx'; async-signal-safe */
+static void nmDeliver(int idx, unsigned overrun)
+{
+    struct nm_run *run = st.run;
+    uint64_t now = nmNow(CLOCK_MONOTONIC);
+    uint64_t due;
+
+    if (st.done)
+        return;
+
+    due = st.next[idx] + (uint64_t)overrun * run->interval;
+    if (run->record != NULL)
+        run->record(run->arg, idx, now > due ? now - due : 0, overrun);
+
+    run->delivered++;
+    run->overruns += overrun;
+    st.next[idx] = due + run->interval;
+    st.lastDelivery = now;
+
+    st.accounted += 1 + (uint64_t)overrun;
+    if (st.accounted >= run->expirations)
+        st.done = 1;
+}
+
+/* Decode sival_int; -1 if it belongs to an earlier run */
+static int nmIndex(int sival)
+{
+    int idx = sival & NM_IDX_MASK;
+
+    if ((sival >> NM_IDX_BITS) != st.gen || idx >= st.run->ntimers)
+        return -1;
+    return idx;
+}
+
+static void nmHandler(int sig, siginfo_t *si, void *uc)
+{
+    int idx = nmIndex(si->si_value.sival_int);
+    int savedErrno = errno;
+
+    if (idx != -1)
+        nmDeliver(idx, si->si_overrun);
+    errno = savedErrno;
+}
+
+static void nmThreadFunc(union sigval sv)
+{
+    int idx, overrun;
+
+    pthread_mutex_lock(&st.lock);
+    if (st.active) {
+        idx = nmIndex(sv.sival_int);
+        if (idx != -1) {
+            overrun = timer_getoverrun(st.tids[idx]);
+            nmDeliver(idx, overrun > 0 ? overrun : 0);
+            if (st.done)
+                pthread_cond_signal(&st.cond);
+        }
+    }
+    pthread_mutex_unlock(&st.lock);
+}
+
+/* Discard queued signals left over from deleted timers */
+static void nmDrain(int sig)
+{
+    struct timespec zero = { 0, 0 };
+    sigset_t set;
+
+    sigemptyset(&set);
+    sigaddset(&set, sig);
+    while (sigtimedwait(&set, NULL, &zero) > 0)
+        continue;
+}
+
+static int nmWaitSignals(const sigset_t *blocked)
+{
+    struct signalfd_siginfo fdsi[NM_BATCH];
+    siginfo_t si;
+    ssize_t n;
+    int sfd, idx, j;
+
+    if (st.run->mech == NM_SIGWAITINFO) {
+        while (!st.done) {
+            if (sigwaitinfo(blocked, &si) == -1) {
+                if (errno == EINTR)
+                    continue;
+                return -1;
+            }
+            idx = nmIndex(si.si_value.sival_int);
+            if (idx != -1)
+                nmDeliver(idx, si.si_overrun);
+        }
+        return 0;
+    }
+
+    sfd = signalfd(-1, blocked, SFD_CLOEXEC);
+    if (sfd == -1)
+        return -1;
+
+    while (!st.done) {
+        n = read(sfd, fdsi, sizeof(fdsi));
+        if (n == -1) {
+            if (errno == EINTR)
+                continue;
+            close(sfd);
+            return -1;
+        }
+        for (j = 0; j < n / (ssize_t)sizeof(fdsi[0]) && !st.done; j++) {
+            idx = nmIndex(fdsi[j].ssi_int);
+            if (idx != -1)
+                nmDeliver(idx, fdsi[j].ssi_overrun);
+        }
+    }
+
+    close(sfd);
+    return 0;
+}
+
+static int nmWaitTimerfds(int epfd)
+{
+    struct epoll_event evlist[NM_BATCH];
+    uint64_t count;
+    int ready, j, idx;
+
+    while (!st.done) {
+        ready = epoll_wait(epfd, evlist, NM_BATCH, -1);
+        if (ready == -1) {
+            if (errno == EINTR)
+                continue;
+            return -1;
+        }
+        for (j = 0; j < ready && !st.done; j++) {
+            idx = evlist[j].data.u32;
+            if (read(st.fds[idx], &count, sizeof(count)) != sizeof(count))
+                continue;
+            nmDeliver(idx, count - 1);
+        }
+    }
+    return 0;
+}
+
+int nmRun(struct nm_run *run)
+{
+    struct itimerspec its;
+    struct sigevent sev;
+    struct sigaction sa, oldSa;
+    struct epoll_event ev;
+    sigset_t blocked, oldMask, waitMask;
+    uint64_t start, offset, mono;
+    int sig, created = 0, epfd = -1, ret = -1, savedErrno, j;
+
+    if (run->ntimers <= 0 || run->ntimers > NM_IDX_MASK + 1) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    st.run = run;
+    st.gen = (st.gen + 1) & ((1 << (31 - NM_IDX_BITS)) - 1);
+    st.accounted = 0;
+    st.done = 0;
+    run->delivered = 0;
+    run->overruns = 0;
+    run->elapsed = 0;
+
+    st.next = calloc(run->ntimers, sizeof(uint64_t));
+    st.tids = calloc(run->ntimers, sizeof(timer_t));
+    st.fds = calloc(run->ntimers, sizeof(int));
+    if (st.next == NULL || st.tids == NULL || st.fds == NULL)
+        goto out;
+
+    sig = (run->mech == NM_SIGUSR1) ? SIGUSR1 : SIGRTMIN;
+    sigemptyset(&blocked);
+    sigaddset(&blocked, sig);
+    pthread_sigmask(SIG_BLOCK, &blocked, &oldMask);
+
+    if (run->mech == NM_SIGUSR1 || run->mech == NM_SIGRT) {
+        sa.sa_flags = SA_SIGINFO | SA_RESTART;
+        sa.sa_sigaction = nmHandler;
+        sigemptyset(&sa.sa_mask);
+        if (sigaction(sig, &sa, &oldSa) == -1)
+            goto out_mask;
+    }
+
+    if (run->mech == NM_TIMERFD) {
+        epfd = epoll_create1(EPOLL_CLOEXEC);
+        if (epfd == -1)
+            goto out_mask;
+    }
+
+    /* Absolute deadlines on the monotonic clock, shifted onto the timers'
+       own clock by the offset between the two */
+    mono = nmNow(CLOCK_MONOTONIC);
+    offset = nmNow(run->clock) - mono;
+    start = mono + run->first;
+    for (j = 0; j < run->ntimers; j++)
+        st.next[j] = start + (uint64_t)j * run->stagger;
+
+    memset(&sev, 0, sizeof(sev));
+    if (run->mech == NM_THREAD) {
+        sev.sigev_notify = SIGEV_THREAD;
+        sev.sigev_notify_function = nmThreadFunc;
+    } else {
+        sev.sigev_notify = SIGEV_SIGNAL;
+        sev.sigev_signo = sig;
+    }
+
+    for (created = 0; created < run->ntimers; created++) {
+        j = created;
+        if (run->mech == NM_TIMERFD) {
+            st.fds[j] = timerfd_create(run->clock, TFD_NONBLOCK | TFD_CLOEXEC);
+            if (st.fds[j] == -1)
+                goto out_timers;
+            ev.events = EPOLLIN;
+            ev.data.u32 = j;
+            if (epoll_ctl(epfd, EPOLL_CTL_ADD, st.fds[j], &ev) == -1) {
+                close(st.fds[j]);
+                goto out_timers;
+            }
+        } else {
+            sev.sigev_value.sival_int = (st.gen << NM_IDX_BITS) | j;
+            if (timer_create(run->clock, &sev, &st.tids[j]) == -1)
+                goto out_timers;
+        }
+    }
+
+    st.active = 1;
+    nmNsToTimespec(run->interval, &its.it_interval);
+    for (j = 0; j < run->ntimers; j++) {
+        nmNsToTimespec(st.next[j] + offset, &its.it_value);
+        if (run->mech == NM_TIMERFD) {
+            if (timerfd_settime(st.fds[j], TFD_TIMER_ABSTIME, &its, NULL) == -1)
+                goto out_timers;
+        } else if (timer_settime(st.tids[j], TIMER_ABSTIME, &its, NULL) == -1) {
+            goto out_timers;
+        }
+    }
+
+    switch (run->mech) {
+    case NM_SIGUSR1:
+    case NM_SIGRT:
+        waitMask = oldMask;
+        sigdelset(&waitMask, sig);
+        while (!st.done)
+            sigsuspend(&waitMask);
+        ret = 0;
+        break;
+    case NM_SIGWAITINFO:
+    case NM_SIGNALFD:
+        ret = nmWaitSignals(&blocked);
+        break;
+    case NM_TIMERFD:
+        ret = nmWaitTimerfds(epfd);
+        break;
+    case NM_THREAD:
+        pthread_mutex_lock(&st.lock);
+        while (!st.done)
+            pthread_cond_wait(&st.cond, &st.lock);
+        pthread_mutex_unlock(&st.lock);
+        ret = 0;
+        break;
+    default:
+        errno = EINVAL;
+        break;
+    }
+
+    if (ret == 0)
+        run->elapsed = st.lastDelivery - start;
+
+out_timers:
+    savedErrno = errno;
+
+    /* Stop SIGEV_THREAD callbacks before the timers go away */
+    pthread_mutex_lock(&st.lock);
+    st.active = 0;
+    st.done = 1;
+    pthread_mutex_unlock(&st.lock);
+
+    for (j = 0; j < created; j++) {
+        if (run->mech == NM_TIMERFD)
+            close(st.fds[j]);
+        else
+            timer_delete(st.tids[j]);
+    }
+    if (epfd != -1)
+        close(epfd);
+    errno = savedErrno;
+
+out_mask:
+    savedErrno = errno;
+    if (run->mech != NM_THREAD && run->mech != NM_TIMERFD)
+        nmDrain(sig);
+    if (run->mech == NM_SIGUSR1 || run->mech == NM_SIGRT)
+        sigaction(sig, &oldSa, NULL);
+    pthread_sigmask(SIG_SETMASK, &oldMask, NULL);
+    errno = savedErrno;
+
+out:
+    free(st.next);
+    free(st.tids);
+    free(st.fds);
+    st.next = NULL;
+    st.tids = NULL;
+    st.fds = NULL;
+    return ret;
+}
@@ -0,0 +1,61 @@
+// notify_mech.h
+#ifndef NOTIFY_MECH_H
+#define NOTIFY_MECH_H
+
+#include <stdint.h>
+#include <time.h>
+
+/*
+ * Runs one identical timer workload through a chosen notification
+ * mechanism, for the benchmarks. Every timer is armed with an absolute
+ * deadline, so how late each delivery is can be measured exactly against
+ * CLOCK_MONOTONIC whatever clock the timers themselves run on.
+ */
+
+enum nm_mech {
+    NM_SIGUSR1,         /* SIGUSR1 + SA_SIGINFO handler */
+    NM_SIGRT,           /* SIGRTMIN + SA_SIGINFO handler */
+    NM_SIGWAITINFO,     /* SIGRTMIN blocked, sigwaitinfo() loop */
+    NM_SIGNALFD,        /* SIGRTMIN blocked, batched signalfd reads */
+    NM_TIMERFD,         /* One timerfd per timer, epoll_wait() */
+    NM_THREAD,          /* SIGEV_THREAD callbacks */
+    NM_COUNT
+};
+
+extern const char *nmNames[NM_COUNT];
+
+/* Mechanism called 'name', or -1 if there is none */
+int nmLookup(const char *name);
+
+/* Called once per notification: 'lateness' is measured from the most
+   recent expiration the notification reports, and 'overrun' counts the
+   expirations folded into it */
+typedef void (*nm_record_fn)(void *arg, int timer, uint64_t lateness,
+                             unsigned overrun);
+
+/* An nm_record_fn adding each lateness to the struct hdr_hist in 'arg' */
+void nmRecordLateness(void *arg, int timer, uint64_t lateness,
+                      unsigned overrun);
+
+struct nm_run {
+    /* Workload */
+    enum nm_mech mech;
+    clockid_t clock;            /* CLOCK_REALTIME, CLOCK_MONOTONIC, ... */
+    int ntimers;
+    uint64_t first;             /* First deadline, ns after the start */
+    uint64_t stagger;           /* Extra delay per timer index, ns */
+    uint64_t interval;          /* Period in ns, 0 for one-shot timers */
+    uint64_t expirations;       /* Stop after this many (incl. overruns) */
+    nm_record_fn record;        /* May be NULL */
+    void *arg;
+
+    /* Results */
+    uint64_t delivered;         /* Notifications received */
+    uint64_t overruns;          /* Expirations folded into overruns */
+    uint64_t elapsed;           /* First deadline to last delivery, ns */
+};
+
+/* Returns 0, or -1 with errno set (e.g. EAGAIN when out of timers) */
+int nmRun(struct nm_run *run);
+
+#endif
@@ -0,0 +1,164 @@
+// overrun_stats.c
+#include <stdlib.h>
+#include "overrun_stats.h"
+
+static const char *classNames[OS_NCLASSES] = {
+    "one-shot", "<1ms", "1-10ms", "10-100ms", "100ms-1s", "1-10s", ">=10s"
+};
+
+static void osCounterInit(struct os_counter *c, int periodClass)
+{
+    atomic_init(&c->notifications, 0);
+    atomic_init(&c->overruns, 0);
+    atomic_init(&c->maxOverrun, 0);
+    c->periodClass = periodClass;
+}
+
+static void osCounterAdd(struct os_counter *c, uint64_t overrun)
+{
+    unsigned long max;
+
+    atomic_fetch_add_explicit(&c->notifications, 1, memory_order_relaxed);
+    if (overrun == 0)
+        return;
+
+    atomic_fetch_add_explicit(&c->overruns, overrun, memory_order_relaxed);
+    max = atomic_load_explicit(&c->maxOverrun, memory_order_relaxed);
+    while (overrun > max &&
+           !atomic_compare_exchange_weak_explicit(&c->maxOverrun, &max,
+                    overrun, memory_order_relaxed, memory_order_relaxed))
+        continue;
+}
+
+int osInit(struct overrun_stats *os, int ntimers)
+{
+    int j;
+
+    os->timers = aligned_alloc(OS_CACHE_LINE,
+                               ntimers * sizeof(struct os_counter));
+    if (os->timers == NULL)
+        return -1;
+    os->ntimers = ntimers;
+
+    for (j = 0; j < ntimers; j++)
+        osCounterInit(&os->timers[j], OS_ONESHOT);
+    for (j = 0; j < OS_NCLASSES; j++)
+        osCounterInit(&os->classes[j], j);
+    for (j = 0; j < OS_HIST_BUCKETS; j++)
+        atomic_init(&os->hist[j], 0);
+    return 0;
+}
+
+void osSetPeriod(struct overrun_stats *os, int timer, uint64_t periodNs)
+{
+    int cls;
+
+    if (periodNs == 0)
+        cls = OS_ONESHOT;
+    else if (periodNs < 1000000)
+        cls = OS_SUB_MS;
+    else if (periodNs < 10000000)
+        cls = OS_MS;
+    else if (periodNs < 100000000)
+        cls = OS_10MS;
+    else if (periodNs < 1000000000)
+        cls = OS_100MS;
+    else if (periodNs < 10000000000ULL)
+        cls = OS_SEC;
+    else
+        cls = OS_LONG;
+
+    os->timers[timer].periodClass = cls;
+}
+
+void osRecord(struct overrun_stats *os, int timer, uint64_t overrun)
+{
+    struct os_counter *c;
+    int bucket;
+
+    if (timer < 0 || timer >= os->ntimers)
+        return;
+
+    c = &os->timers[timer];
+    osCounterAdd(c, overrun);
+    osCounterAdd(&os->classes[c->periodClass], overrun);
+
+    /* Bucket 0 holds overrun 0; bucket b holds [2^(b-1), 2^b) */
+    bucket = overrun ? 64 - __builtin_clzll(overrun) : 0;
+    if (bucket >= OS_HIST_BUCKETS)
+        bucket = OS_HIST_BUCKETS - 1;
+    atomic_fetch_add_explicit(&os->hist[bucket], 1, memory_order_relaxed);
+}
+
+void osTotals(struct overrun_stats *os, uint64_t *notifications,
+              uint64_t *overruns)
+{
+    int j;
+
+    *notifications = 0;
+    *overruns = 0;
+    for (j = 0; j < OS_NCLASSES; j++) {
+        *notifications += atomic_load_explicit(&os->classes[j].notifications,
+                                               memory_order_relaxed);
+        *overruns += atomic_load_explicit(&os->classes[j].overruns,
+                                          memory_order_relaxed);
+    }
+}
+
+void osReport(struct overrun_stats *os, FILE *fp, int top)
+{
+    unsigned long n, o, best, shown[16];
+    int j, k, pick, nshown = 0;
+
+    fprintf(fp, "Overruns by period class:\n");
+    for (j = 0; j < OS_NCLASSES; j++) {
+        n = atomic_load_explicit(&os->classes[j].notifications, memory_order_relaxed);
+        o = atomic_load_explicit(&os->classes[j].overruns, memory_order_relaxed);
+        if (n == 0)
+            continue;
+        fprintf(fp, "  %-9s %10lu notifications %10lu overruns (max %lu)\n",
+                classNames[j], n, o,
+                atomic_load_explicit(&os->classes[j].maxOverrun, memory_order_relaxed));
+    }
+
+    fprintf(fp, "Overrun size histogram:\n");
+    for (j = 0; j < OS_HIST_BUCKETS; j++) {
+        n = atomic_load_explicit(&os->hist[j], memory_order_relaxed);
+        if (n == 0)
+            continue;
+        if (j == 0)
+            fprintf(fp, "  %15s %10lu\n", "0", n);
+        else if (j == OS_HIST_BUCKETS - 1)
+            fprintf(fp, "  %9lu-     %10lu\n", 1UL << (j - 1), n);
+        else
+            fprintf(fp, "  %7lu-%-7lu %10lu\n", 1UL << (j - 1), (1UL << j) - 1, n);
+    }
+
+    /* Timers with the most overruns (a small selection, no sorting) */
+    if (top > 16)
+        top = 16;
+    for (k = 0; k < top; k++) {
+        pick = -1;
+        best = 0;
+        for (j = 0; j < os->ntimers; j++) {
+            o = atomic_load_explicit(&os->timers[j].overruns, memory_order_relaxed);
+            if (o <= best)
+                continue;
+            for (n = 0; n < (unsigned long)nshown && shown[n] != (unsigned long)j; n++)
+                continue;
+            if (n == (unsigned long)nshown) {
+                pick = j;
+                best = o;
+            }
+        }
+        if (pick == -1)
+            break;
+        if (nshown == 0)
+            fprintf(fp, "Timers with the most overruns:\n");
+        shown[nshown++] = pick;
+        fprintf(fp, "  timer %-6d %10lu overruns in %lu notifications (max %lu)\n",
+                pick + 1, best,
+                atomic_load_explicit(&os->timers[pick].notifications, memory_order_relaxed),
+                atomic_load_explicit(&os->timers[pick].maxOverrun, memory_order_relaxed));
+    }
+}
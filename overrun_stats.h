@@ -0,0 +1,66 @@
+// overrun_stats.h
+#ifndef OVERRUN_STATS_H
+#define OVERRUN_STATS_H
+
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdio.h>
+
+/*
+ * Overrun accounting for a population of timers.
+ *
+ * osRecord() adds one expiration notification and its overrun count to
+ * the timer's own counters, to the counters of the timer's period class
+ * and to a log2 histogram of overrun sizes. Every counter is a relaxed
+ * lock-free atomic, so recording is async-signal-safe and may happen on
+ * several threads at once; per-timer and per-class counters sit in their
+ * own cache lines so that concurrent writers do not false-share. Readers
+ * (osReport()) can run at any time without stopping the timers.
+ */
+
+#define OS_CACHE_LINE 64
+#define OS_HIST_BUCKETS 18      /* 0, 1, 2-3, 4-7, ..., >= 65536 */
+
+enum os_class {
+    OS_ONESHOT,
+    OS_SUB_MS,                  /* period < 1 ms */
+    OS_MS,                      /* 1 ms  <= period < 10 ms */
+    OS_10MS,                    /* 10 ms <= period < 100 ms */
+    OS_100MS,                   /* 100 ms <= period < 1 s */
+    OS_SEC,                     /* 1 s <= period < 10 s */
+    OS_LONG,                    /* period >= 10 s */
+    OS_NCLASSES
+};
+
+struct os_counter {
+    atomic_ulong notifications; /* Expirations that were delivered */
+    atomic_ulong overruns;      /* Expirations folded into overruns */
+    atomic_ulong maxOverrun;    /* Largest single overrun seen */
+    int periodClass;
+} __attribute__((aligned(OS_CACHE_LINE)));
+
+struct overrun_stats {
+    int ntimers;
+    struct os_counter *timers;
+    struct os_counter classes[OS_NCLASSES];
+    atomic_ulong hist[OS_HIST_BUCKETS];
+};
+
+/* Returns -1 if the per-timer counters cannot be allocated */
+int osInit(struct overrun_stats *os, int ntimers);
+
+/* Classify timer 'timer' by its period (0 for a one-shot timer) */
+void osSetPeriod(struct overrun_stats *os, int timer, uint64_t periodNs);
+
+/* Async-signal-safe and thread-safe */
+void osRecord(struct overrun_stats *os, int timer, uint64_t overrun);
+
+/* Totals over every timer so far */
+void osTotals(struct overrun_stats *os, uint64_t *notifications,
+              uint64_t *overruns);
+
+/* Print per-class totals, the overrun histogram and the 'top' timers
+   with the most overruns */
+void osReport(struct overrun_stats *os, FILE *fp, int top);
+
+#endif
@@ -0,0 +1,184 @@
+// perf_counters.c
+#define _GNU_SOURCE
+#include <errno.h>
+#include <linux/perf_event.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+#include "perf_counters.h"
+
+const char *pcNames[PC_NEVENTS] = {
+    "cycles", "instructions", "cache-misses", "context-switches"
+};
+
+static const struct {
+    uint32_t type;
+    uint64_t config;
+} pcEvents[PC_NEVENTS] = {
+    { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES },
+    { PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS },
+    { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES },
+    { PERF_TYPE_SOFTWARE, PERF_COUNT_SW_CONTEXT_SWITCHES },
+};
+
+static uint64_t pcNow(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static int pcOpenEvent(int e, int group, int excludeKernel)
+{
+    struct perf_event_attr attr;
+
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = pcEvents[e].type;
+    attr.config = pcEvents[e].config;
+    attr.read_format = PERF_FORMAT_GROUP;
+    attr.disabled = (group == -1);      /* Leader enables the group */
+    attr.exclude_kernel = excludeKernel;
+    attr.exclude_hv = 1;
+
+    /* This thread, any CPU */
+    return syscall(SYS_perf_event_open, &attr, 0, -1, group, 0);
+}
+
+/* Open every event the machine has; -1 if kernel counting is refused */
+static int pcOpenGroup(struct perf_counters *pc, int excludeKernel)
+{
+    int e, fd;
+
+    for (e = 0; e < PC_NEVENTS; e++) {
+        fd = pcOpenEvent(e, pc->leader, excludeKernel);
+        if (fd == -1) {
+            if (!excludeKernel && (errno == EACCES || errno == EPERM))
+                return -1;
+            continue;                   /* Not on this machine */
+        }
+
+        if (pc->leader == -1)
+            pc->leader = fd;
+        pc->fds[e] = fd;
+        pc->slot[e] = pc->nopen++;
+    }
+
+    pc->userOnly = excludeKernel;
+    return 0;
+}
+
+int pcOpen(struct perf_counters *pc)
+{
+    int e;
+
+    memset(pc, 0, sizeof(*pc));
+    for (e = 0; e < PC_NEVENTS; e++) {
+        pc->fds[e] = -1;
+        pc->slot[e] = -1;
+    }
+    pc->leader = -1;
+
+    /* perf_event_paranoid >= 2 allows user space only; then every event
+       excludes the kernel so that the group's counts stay comparable */
+    if (pcOpenGroup(pc, 0) == -1) {
+        pcClose(pc);
+        pcOpenGroup(pc, 1);
+    }
+
+    if (pc->nopen == 0) {
+        errno = ENOENT;
+        return -1;
+    }
+
+    if (ioctl(pc->leader, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP) == -1) {
+        pcClose(pc);
+        return -1;
+    }
+
+    pc->since = pcNow();
+    return pc->nopen;
+}
+
+void pcClose(struct perf_counters *pc)
+{
+    int e;
+
+    for (e = 0; e < PC_NEVENTS; e++) {
+        if (pc->fds[e] != -1)
+            close(pc->fds[e]);
+        pc->fds[e] = -1;
+        pc->slot[e] = -1;
+    }
+    pc->leader = -1;
+    pc->nopen = 0;
+    pc->userOnly = 0;
+}
+
+/* One read() of the whole group: { nr, value[nr] } */
+static int pcRead(const struct perf_counters *pc, uint64_t *values)
+{
+    uint64_t buf[1 + PC_NEVENTS];
+    int e;
+
+    if (read(pc->leader, buf, sizeof(buf)) < (ssize_t)sizeof(uint64_t))
+        return -1;
+
+    for (e = 0; e < PC_NEVENTS; e++)
+        values[e] = (pc->slot[e] != -1) ? buf[1 + pc->slot[e]] : 0;
+    return 0;
+}
+
+void pcBegin(struct perf_counters *pc)
+{
+    if (pc->nopen > 0)
+        pcRead(pc, pc->start);
+}
+
+void pcEnd(struct perf_counters *pc, uint64_t expirations)
+{
+    uint64_t now[PC_NEVENTS];
+    int e;
+
+    if (pc->nopen == 0 || pcRead(pc, now) == -1)
+        return;
+
+    for (e = 0; e < PC_NEVENTS; e++)
+        pc->total[e] += now[e] - pc->start[e];
+    pc->batches++;
+    pc->expirations += expirations;
+}
+
+uint64_t pcElapsed(const struct perf_counters *pc)
+{
+    return pcNow() - pc->since;
+}
+
+void pcReport(struct perf_counters *pc, FILE *fp, const char *label)
+{
+    uint64_t n = pc->expirations;
+    int e;
+
+    if (pc->nopen == 0)
+        return;
+
+    fprintf(fp, "perf [%s]: %llu expirations in %llu batches (%s); per expiration:",
+            label, (unsigned long long)n, (unsigned long long)pc->batches,
+            pc->userOnly ? "user space only" : "user+kernel");
+    for (e = 0; e < PC_NEVENTS; e++) {
+        if (pc->slot[e] == -1)
+            fprintf(fp, " %s n/a", pcNames[e]);
+        else
+            fprintf(fp, " %s %.1f", pcNames[e],
+                    n ? (double)pc->total[e] / n : 0.0);
+        fprintf(fp, e < PC_NEVENTS - 1 ? "," : "\n");
+    }
+
+    memset(pc->total, 0, sizeof(pc->total));
+    pc->batches = 0;
+    pc->expirations = 0;
+    pc->since = pcNow();
+}
@@ -0,0 +1,58 @@
+// perf_counters.h
+#ifndef PERF_COUNTERS_H
+#define PERF_COUNTERS_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+/*
+ * Hardware and software performance counters for the calling thread,
+ * sampled around each dispatch batch with perf_event_open().
+ *
+ * The counters are opened as one group, so pcBegin() and pcEnd() each
+ * cost a single read(); both are async-signal-safe. Counts are only
+ * accumulated while the thread runs, so time spent blocked in a wait
+ * does not inflate them. Kernel-side work (signal delivery, wakeups) is
+ * included unless perf_event_paranoid forbids it, in which case the
+ * counters fall back to user space only. Events the machine does not
+ * have (e.g. hardware counters in a VM) are reported as unavailable.
+ */
+
+enum pc_event {
+    PC_CYCLES,
+    PC_INSTRUCTIONS,
+    PC_CACHE_MISSES,
+    PC_CONTEXT_SWITCHES,
+    PC_NEVENTS
+};
+
+extern const char *pcNames[PC_NEVENTS];
+
+struct perf_counters {
+    int nopen;                  /* Events in the group; 0 = disabled */
+    int leader;                 /* Group leader fd */
+    int fds[PC_NEVENTS];
+    int slot[PC_NEVENTS];       /* Position in the group read, or -1 */
+    int userOnly;               /* Kernel work excluded */
+    uint64_t start[PC_NEVENTS];
+    uint64_t total[PC_NEVENTS];
+    uint64_t batches;
+    uint64_t expirations;
+    uint64_t since;             /* CLOCK_MONOTONIC ns of the last reset */
+};
+
+/* Returns the number of events opened, or -1 with errno set if none */
+int pcOpen(struct perf_counters *pc);
+void pcClose(struct perf_counters *pc);
+
+/* Bracket one dispatch batch that handled 'expirations' expirations */
+void pcBegin(struct perf_counters *pc);
+void pcEnd(struct perf_counters *pc, uint64_t expirations);
+
+/* Nanoseconds since the totals were last reset */
+uint64_t pcElapsed(const struct perf_counters *pc);
+
+/* Print per-expiration averages under 'label', then reset the totals */
+void pcReport(struct perf_counters *pc, FILE *fp, const char *label);
+
+#endif
@@ -0,0 +1,45 @@
+// ptmr_probes.h
+#ifndef PTMR_PROBES_H
+#define PTMR_PROBES_H
+
+/*
+ * USDT (user statically defined tracing) probes, provider "ptmr", across
+ * the timer lifecycle:
+ *
+ *   create  (id, timer)                    timer_create()/timerfd_create()
+ *   settime (id, flags, value-ns, interval-ns)  timer_settime() and friends
+ *   deliver (id, overrun)                  an expiration reaches user space
+ *   overrun (id, overrun)                  ... and it folded in overruns
+ *   delete  (id, timer)                    timer_delete()
+ *
+ * 'id' is the 1-based command-line spec, or 0 for the single kernel timer
+ * behind the wheel and heap backends. With <sys/sdt.h> (systemtap-sdt-dev)
+ * each probe is a single nop plus an ELF note, so tools such as
+ * "bpftrace -e 'usdt:./ptmr_sigev_signal:ptmr:deliver { ... }'" or perf
+ * can attach to an unmodified binary and line the events up with kernel
+ * tracepoints (timer:hrtimer_expire_entry, sched:sched_wakeup). Without
+ * the header the probes compile to nothing and their arguments are not
+ * evaluated.
+ */
+
+#if defined(__has_include)
+#if __has_include(<sys/sdt.h>)
+#include <sys/sdt.h>
+#define PTMR_HAVE_SDT 1
+#endif
+#endif
+
+#ifdef PTMR_HAVE_SDT
+#define PTMR_PROBE2(name, a1, a2) STAP_PROBE2(ptmr, name, a1, a2)
+#define PTMR_PROBE4(name, a1, a2, a3, a4) \
+    STAP_PROBE4(ptmr, name, a1, a2, a3, a4)
+#else
+#define PTMR_PROBE2(name, a1, a2) do { } while (0)
+#define PTMR_PROBE4(name, a1, a2, a3, a4) do { } while (0)
+#endif
+
+/* Nanoseconds in a timespec, for the settime probe */
+#define PTMR_TS_NS(tsp) \
+    ((unsigned long long)(tsp)->tv_sec * 1000000000 + (tsp)->tv_nsec)
+
+#endif
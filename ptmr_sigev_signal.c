@@ -1,41 +1,537 @@
-#define _POSIX_C_SOURCE 199309
+#define _GNU_SOURCE         /* For CPU affinity and gettid() */
+#include <poll.h>
+#include <pthread.h>
+#include <sched.h>
 #include <signal.h>
+#include <stdint.h>
+#include <sys/epoll.h>
+#include <sys/mman.h>
+#include <sys/signalfd.h>
+#include <sys/timerfd.h>
 #include <time.h>
+#include "clock_offset.h"   /* Wall-clock steps under -a */
 #include "curr_time.h"      /* Custom time formatting function */
+#include "event_ring.h"     /* Async-signal-safe handler -> writer queue */
+#include "exp_trace.h"      /* Binary expiration trace (-t) */
+#include "hdr_hist.h"       /* Dispatch latency quantiles */
+#include "io_ring.h"        /* Minimal raw io_uring wrapper */
 #include "itimerspec_from_str.h" /* For parsing timer specs */
+#include "metrics_shm.h"    /* Live metrics for ptmr_top */
+#include "overrun_stats.h"  /* Per-timer overrun accounting */
+#include "perf_counters.h"  /* perf_event_open() around dispatch */
+#include "ptmr_probes.h"    /* USDT probes across the timer lifecycle */
+#include "timer_heap.h"     /* User-space 4-ary min-heap timer queue */
+#include "timer_pool.h"     /* Slab of timer records with handles */
+#include "timer_wheel.h"    /* User-space hierarchical timing wheel */
+#include "tsc_clock.h"      /* Cheap timestamps for -m/-t */
 #include "tlpi_hdr.h"       /* Error handling functions */
 
 #define TIMER_SIG SIGUSR1  /* Change to SIGUSR1 for compatibility */
 
-/* Signal handler for timer expiration */
+#define USAGE "%s [-a] [-m] [-p] [-o report-secs] [-t trace-file] [-f spec-file] [-b posix|wheel|timerfd|signalfd|percpu|heap|uring] [secs[/nsecs][:int-secs[/int-nsecs]][~slack-secs[/slack-nsecs]]]...\n"
+
+#define WHEEL_TICK_NS 1000000   /* Wheel resolution: 1 ms per tick */
+
+#define MAX_EVENTS 64           /* epoll_wait() batch size */
+#define MAX_SIGINFO 64          /* signalfd records per read() */
+
+#define EVENT_RING_SIZE 4096    /* Handler records buffered for the writer */
+#define EVENT_BATCH 256         /* Records formatted per write */
+#define EVENT_POLL_NS 10000000  /* Writer polls the ring every 10 ms */
+
+#define URING_ENTRIES 256       /* io_uring submission queue size */
+
+#ifndef IORING_TIMEOUT_MULTISHOT
+#define IORING_TIMEOUT_MULTISHOT (1U << 6)      /* Linux 6.4 */
+#endif
+
+#define STATS_INTERVAL_NS 10000000000ULL  /* Coalescing report period */
+#define METRICS_PERIOD_MS 1000  /* -m: shared memory publishing period */
+#define TRACE_BYTES (64 << 20)  /* -t: ring size, about 10M records */
+
+#ifndef sigev_notify_thread_id
+#define sigev_notify_thread_id _sigev_un._tid
+#endif
+
+static struct event_ring events;   /* handler() -> eventWriter() */
+static struct timer_pool pool;      /* Timer records, keyed by handle */
+static struct overrun_stats ostats; /* Overruns per timer and period */
+static struct perf_counters perf;   /* Dispatch thread's counters (-p) */
+static atomic_ulong handled;        /* handler() runs, for -p batches */
+
+/* Where each spec's next expiration is due, to measure how late it is
+   dispatched (-m) */
+struct deadline {
+    uint64_t next;              /* CLOCK_MONOTONIC ns */
+    uint64_t interval;          /* 0 for a one-shot timer */
+    int wallClock;              /* -a: armed on the CLOCK_REALTIME grid */
+    int64_t offset;             /* REALTIME - MONOTONIC behind 'next' */
+};
+
+static struct deadline *deadlines;  /* Indexed by spec */
+static atomic_long activeTimers;    /* Armed and not yet finished */
+static atomic_ulong lastBatch;      /* Expirations in the latest batch */
+static struct {
+    atomic_ulong counts[HH_BUCKETS];    /* hdr_hist buckets, lock-free */
+    atomic_ulong max;
+} latency;                          /* Drained by metricsPublisher() */
+static char metricsName[MS_NAME_MAX];
+static struct exp_trace trace;      /* -t: binary expiration trace */
+static atomic_flag traceLock = ATOMIC_FLAG_INIT;
+static struct tsc_clock tsc;        /* Falls back to clock_gettime() */
+static struct clock_offset clockOffset = { .fd = -1 };
+
+static int absFlag = 0;     /* -a: arm kernel timers on an absolute grid */
+static int perfFlag = 0;    /* -p: count cycles etc. per dispatch batch */
+static int metricsFlag = 0; /* -m: publish live metrics in shared memory */
+
+static uint64_t monotonicNs(void)
+{
+    struct timespec now;
+
+    if (clock_gettime(CLOCK_MONOTONIC, &now) == -1)
+        errExit("clock_gettime");
+    return (uint64_t)now.tv_sec * 1000000000 + now.tv_nsec;
+}
+
+/* With -a, convert a relative spec into an absolute deadline on the
+   timer's phase grid: the first multiple of it_interval (counted from the
+   clock's epoch) at or after now + it_value. The kernel then advances
+   each period from the previous deadline, so wakeup latency never
+   accumulates and the job stays locked to its phase. A CLOCK_REALTIME
+   deadline is read and kept as CLOCK_MONOTONIC ns through the cached
+   clock offset, and rebased by rebaseDeadline() if the clock steps */
+static void phaseAlign(int id, clockid_t clockid, struct itimerspec *ts)
+{
+    struct deadline *d = &deadlines[id - 1];
+    struct timespec now;
+    uint64_t nowNs, first, aligned, period;
+
+    if (!absFlag || (ts->it_value.tv_sec == 0 && ts->it_value.tv_nsec == 0))
+        return;
+
+    if (clockid == CLOCK_REALTIME) {
+        nowNs = coToReal(&clockOffset, monotonicNs());
+    } else {
+        if (clock_gettime(clockid, &now) == -1)
+            errExit("clock_gettime");
+        nowNs = (uint64_t)now.tv_sec * 1000000000 + now.tv_nsec;
+    }
+
+    first = nowNs + (uint64_t)ts->it_value.tv_sec * 1000000000 +
+            ts->it_value.tv_nsec;
+    period = (uint64_t)ts->it_interval.tv_sec * 1000000000 +
+             ts->it_interval.tv_nsec;
+    aligned = (period != 0) ? (first + period - 1) / period * period : first;
+
+    if (clockid == CLOCK_REALTIME) {
+        d->wallClock = 1;
+        d->offset = coOffset(&clockOffset);
+        d->next = coToMono(&clockOffset, aligned);
+    } else {
+        d->next += aligned - first;
+    }
+
+    ts->it_value.tv_sec = aligned / 1000000000;
+    ts->it_value.tv_nsec = aligned % 1000000000;
+}
+
+/* Classify spec 'id' (1-based) by its period for overrun accounting, and
+   note when its first expiration is due */
+static void notePeriod(int id, const struct itimerspec *ts)
+{
+    struct deadline *d = &deadlines[id - 1];
+
+    d->interval = (uint64_t)ts->it_interval.tv_sec * 1000000000 +
+                  ts->it_interval.tv_nsec;
+    osSetPeriod(&ostats, id - 1, d->interval);
+
+    if (ts->it_value.tv_sec != 0 || ts->it_value.tv_nsec != 0) {
+        d->next = monotonicNs() + (uint64_t)ts->it_value.tv_sec * 1000000000 +
+                  ts->it_value.tv_nsec;
+        atomic_fetch_add_explicit(&activeTimers, 1, memory_order_relaxed);
+    }
+}
+
+/* -m: record how long after its deadline an expiration was dispatched */
+static void noteLateness(uint64_t late)
+{
+    unsigned long max;
+
+    atomic_fetch_add_explicit(&latency.counts[hhIndex(late)], 1,
+                              memory_order_relaxed);
+    max = atomic_load_explicit(&latency.max, memory_order_relaxed);
+    while (late > max &&
+           !atomic_compare_exchange_weak_explicit(&latency.max, &max, late,
+                    memory_order_relaxed, memory_order_relaxed))
+        continue;
+}
+
+/* -t: append a binary trace record keyed by spec id, which unlike a pool
+   handle exists for every backend and survives record recycling;
+   percpu workers share the trace, and the handler never interrupts
+   itself, so a spin lock is safe here */
+static void noteTrace(int id, uint64_t due, uint64_t now, uint64_t overrun)
+{
+    while (atomic_flag_test_and_set_explicit(&traceLock, memory_order_acquire))
+        continue;
+    etAppend(&trace, id, due, now, overrun);
+    atomic_flag_clear_explicit(&traceLock, memory_order_release);
+}
+
+/* An absolute CLOCK_REALTIME timer moves with the wall clock: if it was
+   stepped since 'next' was converted, the same wall-clock deadline now
+   falls elsewhere on the monotonic clock. Only the timer's dispatcher
+   writes its deadline, so it rebases it here, on the next expiration */
+static void rebaseDeadline(struct deadline *d)
+{
+    int64_t offset = coOffset(&clockOffset);
+
+    if (!d->wallClock || d->offset == offset)
+        return;
+    d->next = d->next + d->offset - offset;
+    d->offset = offset;
+}
+
+/* Account one expiration notification of spec 'id'; async-signal-safe.
+   Only the timer's own dispatcher touches its deadline */
+static void noteExpiration(int id, uint64_t overrun)
+{
+    struct deadline *d = &deadlines[id - 1];
+    uint64_t now, due;
+
+    PTMR_PROBE2(deliver, id, overrun);
+    if (overrun > 0)
+        PTMR_PROBE2(overrun, id, overrun);
+    osRecord(&ostats, id - 1, overrun);
+
+    if (!metricsFlag && trace.hdr == NULL)
+        return;
+
+    rebaseDeadline(d);
+    now = tcNow(&tsc);
+    due = d->next + overrun * d->interval;
+    if (metricsFlag)
+        noteLateness(now > due ? now - due : 0);
+    if (trace.hdr != NULL)
+        noteTrace(id, due, now, overrun);
+
+    if (d->interval == 0)
+        atomic_fetch_sub_explicit(&activeTimers, 1, memory_order_relaxed);
+    else
+        d->next = due + d->interval;
+}
+
+/* -p: open the calling thread's counters; without -p, or if none can be
+   opened, pcBegin()/pcEnd() do nothing */
+static void perfStart(struct perf_counters *pc, const char *label)
+{
+    memset(pc, 0, sizeof(*pc));
+    if (perfFlag && pcOpen(pc) == -1)
+        fprintf(stderr, "perf [%s]: no counters available: %s\n", label,
+                strerror(errno));
+}
+
+/* Close a dispatch batch of 'expirations' (also kept as the queue depth
+   for -m); report the counters every STATS_INTERVAL_NS */
+static void perfEnd(struct perf_counters *pc, uint64_t expirations,
+                    const char *label)
+{
+    pcEnd(pc, expirations);
+    atomic_store_explicit(&lastBatch, expirations, memory_order_relaxed);
+    if (pc->nopen > 0 && pcElapsed(pc) >= STATS_INTERVAL_NS)
+        pcReport(pc, stderr, label);
+}
+
+/* -o: print the overrun accounting every 'arg' seconds, while the timers
+   keep running */
+static void *overrunReporter(void *arg)
+{
+    struct timespec interval = { (time_t)(intptr_t)arg, 0 };
+
+    for (;;) {
+        nanosleep(&interval, NULL);
+        osReport(&ostats, stderr, 5);
+    }
+
+    return NULL;
+}
+
+/* -a with -m/-t: wait for wall-clock steps and publish the new offset;
+   each dispatcher then rebases its own deadlines in noteExpiration() */
+static void *clockWatcher(void *arg)
+{
+    struct pollfd pfd = { clockOffset.fd, POLLIN, 0 };
+    int64_t step;
+
+    for (;;) {
+        if (poll(&pfd, 1, -1) == -1) {
+            if (errno == EINTR)
+                continue;
+            errExit("poll");
+        }
+        switch (coCheck(&clockOffset, &step)) {
+        case -1:
+            errExit("coCheck");
+        case 1:
+            fprintf(stderr, "CLOCK_REALTIME stepped by %+.6f s; absolute "
+                    "deadlines rebased\n", step / 1e9);
+            break;
+        }
+    }
+
+    return NULL;
+}
+
+/* Remove the metrics segment and flush the trace, then exit. The trace
+   lock is taken and never given back, so no dispatcher appends to the
+   unmapped ring; TIMER_SIG is blocked first so that a handler on this
+   thread cannot spin on it */
+static void shutdownAndExit(void)
+{
+    sigset_t mask;
+
+    sigemptyset(&mask);
+    sigaddset(&mask, TIMER_SIG);
+    pthread_sigmask(SIG_BLOCK, &mask, NULL);
+
+    if (metricsFlag)
+        shm_unlink(metricsName);
+    if (trace.hdr != NULL) {
+        while (atomic_flag_test_and_set_explicit(&traceLock, memory_order_acquire))
+            continue;
+        if (etClose(&trace) == -1)
+            errExit("etClose");
+    }
+    exit(EXIT_SUCCESS);
+}
+
+/* -t without -m: wait for SIGINT or SIGTERM, which every other thread
+   blocks, and close the trace; meanwhile keep the TSC calibrated, which
+   handlers must not do themselves */
+static void *stopWaiter(void *arg)
+{
+    const struct timespec period = { TC_RECAL_NS / 1000000000, 0 };
+    sigset_t *stop = arg;
+
+    while (sigtimedwait(stop, NULL, &period) <= 0)
+        tcMaintain(&tsc);
+    shutdownAndExit();
+    return NULL;
+}
+
+/* -m: publish a snapshot every METRICS_PERIOD_MS until SIGINT or SIGTERM,
+   which every other thread blocks, then remove the segment */
+static void *metricsPublisher(void *arg)
+{
+    static struct hdr_hist hist;
+    struct ms_segment *seg = arg;
+    struct ms_snapshot snap;
+    const struct timespec period = { METRICS_PERIOD_MS / 1000,
+                                     METRICS_PERIOD_MS % 1000 * 1000000 };
+    uint64_t notifications, overruns, now, prevTime, prevTotal = 0;
+    unsigned long c;
+    sigset_t stop;
+    int j;
+
+    sigemptyset(&stop);
+    sigaddset(&stop, SIGINT);
+    sigaddset(&stop, SIGTERM);
+
+    msRead(seg, &snap);                 /* backend and pid, set by main() */
+    snap.period = METRICS_PERIOD_MS;
+    prevTime = monotonicNs();
+
+    for (;;) {
+        if (sigtimedwait(&stop, NULL, &period) > 0)
+            shutdownAndExit();
+        tcMaintain(&tsc);               /* Never done in handlers */
+
+        now = monotonicNs();
+        osTotals(&ostats, &notifications, &overruns);
+
+        hhInit(&hist);
+        for (j = 0; j < HH_BUCKETS; j++) {
+            c = atomic_exchange_explicit(&latency.counts[j], 0,
+                                         memory_order_relaxed);
+            hist.counts[j] = c;
+            hist.count += c;
+        }
+        hist.max = atomic_exchange_explicit(&latency.max, 0, memory_order_relaxed);
+
+        snap.updated = now;
+        snap.activeTimers = atomic_load_explicit(&activeTimers, memory_order_relaxed);
+        snap.expirations = notifications;
+        snap.overruns = overruns;
+        snap.expirationsPerSec = (notifications + overruns - prevTotal) * 1e9 /
+                                 (now - prevTime);
+
+        /* Default mode: records still in the handler's ring; otherwise
+           what the latest batch found waiting */
+        if (events.slots != NULL)
+            snap.queueDepth =
+                atomic_load_explicit(&events.head, memory_order_relaxed) -
+                atomic_load_explicit(&events.tail, memory_order_relaxed);
+        else
+            snap.queueDepth = atomic_load_explicit(&lastBatch, memory_order_relaxed);
+
+        snap.latencySamples = hist.count;
+        snap.latencyP50 = hhPercentile(&hist, 50);
+        snap.latencyP99 = hhPercentile(&hist, 99);
+        snap.latencyP999 = hhPercentile(&hist, 99.9);
+        snap.latencyMax = hist.max;
+
+        msPublish(seg, &snap);
+        prevTotal = notifications + overruns;
+        prevTime = now;
+    }
+
+    return NULL;
+}
+
+/* Create the segment and start metricsPublisher() */
+static void startMetrics(const char *backend)
+{
+    struct ms_segment *seg;
+    struct ms_snapshot snap;
+    pthread_t publisher;
+    sigset_t mask, prevMask;
+    int s;
+
+    msName(metricsName, sizeof(metricsName), getpid());
+    seg = msCreate(metricsName);
+    if (seg == NULL)
+        errExit("msCreate");
+
+    memset(&snap, 0, sizeof(snap));
+    snprintf(snap.backend, sizeof(snap.backend), "%s", backend);
+    snap.pid = getpid();
+    msPublish(seg, &snap);
+
+    /* Only the publisher takes SIGINT/SIGTERM (so the segment is removed);
+       threads created later inherit the mask */
+    sigemptyset(&mask);
+    sigaddset(&mask, SIGINT);
+    sigaddset(&mask, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &mask, NULL);
+
+    sigaddset(&mask, TIMER_SIG);
+    pthread_sigmask(SIG_BLOCK, &mask, &prevMask);
+    s = pthread_create(&publisher, NULL, metricsPublisher, seg);
+    if (s != 0) {
+        errno = s;
+        errExit("pthread_create");
+    }
+    pthread_sigmask(SIG_SETMASK, &prevMask, NULL);
+
+    printf("Publishing metrics in shared memory object %s\n", metricsName);
+}
+
+/* Signal handler for timer expiration: only async-signal-safe work here.
+   The record is queued and formatted later by eventWriter() */
 static void handler(int sig, siginfo_t *si, void *uc)
 {
-    timer_t *tidptr;
+    struct timer_event ev;
+    struct timespec now;
+    struct tp_record *rec;
+    int savedErrno = errno;     /* clock_gettime() could change errno */
+
+    /* Resolve the handle carried in sival_int; a stale handle means the
+       timer was deleted after this expiration was queued */
+    rec = tpLookup(&pool, si->si_value.sival_int);
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    ev.timestamp = (uint64_t)now.tv_sec * 1000000000 + now.tv_nsec;
+    ev.timer_id = (rec != NULL) ? (long)rec->tid : -1;
+    ev.sival = si->si_value;
+    ev.overrun = si->si_overrun;    /* Saves a timer_getoverrun() call */
+    erPush(&events, &ev);
 
-    /* Get timer ID from signal value */
-    tidptr = si->si_value.sival_ptr;
+    if (rec != NULL)
+        noteExpiration(rec->id, si->si_overrun);
+    atomic_fetch_add_explicit(&handled, 1, memory_order_relaxed);
 
-    /* Debugging output */
-    printf("Received signal %d at %s\n", sig, currTime("%T"));
-    printf("Timer ID: %ld\n", (long)*tidptr);
-    printf("Overrun: %d\n", timer_getoverrun(*tidptr));
+    errno = savedErrno;
 }
 
-int main(int argc, char *argv[])
+/* Consumer thread: drains the event ring in batches and writes each batch
+   with a single stdio flush */
+static void *eventWriter(void *arg)
+{
+    static struct timer_event batch[EVENT_BATCH];
+    static char buf[EVENT_BATCH * 128];
+    const struct timespec pollInterval = { 0, EVENT_POLL_NS };
+    unsigned long dropped, reported = 0;
+    size_t n, len, j;
+
+    for (;;) {
+        n = erPop(&events, batch, EVENT_BATCH);
+        if (n == 0) {
+            nanosleep(&pollInterval, NULL);
+            continue;
+        }
+
+        len = 0;
+        for (j = 0; j < n; j++) {
+            if (batch[j].timer_id == -1) {
+                len += snprintf(buf + len, sizeof(buf) - len,
+                        "Stale expiration for handle %#x ignored\n",
+                        (unsigned)batch[j].sival.sival_int);
+                continue;
+            }
+            len += snprintf(buf + len, sizeof(buf) - len,
+                    "Timer ID: %ld expired at %llu.%09llu (monotonic)\n"
+                    "Overrun: %d\n", batch[j].timer_id,
+                    (unsigned long long)(batch[j].timestamp / 1000000000),
+                    (unsigned long long)(batch[j].timestamp % 1000000000),
+                    batch[j].overrun);
+        }
+
+        dropped = atomic_load_explicit(&events.dropped, memory_order_relaxed);
+        if (dropped != reported) {
+            len += snprintf(buf + len, sizeof(buf) - len,
+                    "Event ring full: %lu record(s) dropped\n",
+                    dropped - reported);
+            reported = dropped;
+        }
+
+        fwrite(buf, 1, len, stdout);
+        fflush(stdout);
+    }
+
+    return NULL;
+}
+
+/* Default mode: one kernel timer per command-line spec */
+static void runPosixTimers(int nspecs, char *specs[])
 {
     struct itimerspec ts;       /* Timer interval specification */
     struct sigaction sa;        /* Signal action structure */
     struct sigevent sev;        /* Timer notification spec */
-    timer_t *tidlist;           /* Array of timer IDs */
-    int j;
+    struct tp_record *rec;      /* Pool record for the current timer */
+    tp_handle h;                /* Its handle (passed via sival_int) */
+    pthread_t writer;           /* Formats the handler's records */
+    sigset_t mask;
+    int s, j;
 
-    if (argc < 2)
-        usageErr("%s secs[/nsecs][:int-secs[/int-nsecs]]...\\n", argv[0]);
+    if (erInit(&events, EVENT_RING_SIZE) == -1)
+        errExit("erInit");
 
-    /* Allocate array for timer IDs */
-    tidlist = calloc(argc - 1, sizeof(timer_t));
-    if (tidlist == NULL)
-        errExit("malloc");
+    /* Start the consumer with TIMER_SIG blocked, so the handler only ever
+       runs in the main thread and the ring keeps a single producer */
+    sigemptyset(&mask);
+    sigaddset(&mask, TIMER_SIG);
+    pthread_sigmask(SIG_BLOCK, &mask, NULL);
+    s = pthread_create(&writer, NULL, eventWriter, NULL);
+    if (s != 0) {
+        errno = s;
+        errExit("pthread_create");
+    }
+    pthread_sigmask(SIG_UNBLOCK, &mask, NULL);
+
+    /* Preallocate every timer record before the handler can run */
+    if (tpInit(&pool, nspecs) == -1)
+        errExit("tpInit");
 
     /* Set up signal handler */
     sa.sa_flags = SA_SIGINFO;    /* Use extended signal handler */
@@ -50,29 +546,893 @@ int main(int argc, char *argv[])
     sev.sigev_signo = TIMER_SIG;      /* Use our chosen signal */
 
     /* Create and start timers for each command-line argument */
-    for (j = 0; j < argc - 1; j++) {
+    for (j = 0; j < nspecs; j++) {
         /* Parse timer spec from command-line argument */
-        itimerspecFromStr(argv[j + 1], &ts);
+        itimerspecFromStr(specs[j], &ts);
+        notePeriod(j + 1, &ts);
 
         /* Debugging: print the parsed timer spec */
         printf("Setting timer with expiration: %ld sec and %ld nsec\n", ts.it_value.tv_sec, ts.it_value.tv_nsec);
 
-        /* Store timer ID in array (passed to handler via sival_ptr) */
-        sev.sigev_value.sival_ptr = &tidlist[j];
+        /* Take a record from the pool (passed to handler via sival_int) */
+        h = tpAlloc(&pool);
+        if (h == TP_INVALID)
+            usageErr("Timer pool exhausted at spec %d\n", j + 1);
+        rec = tpLookup(&pool, h);
+        rec->id = j + 1;
+        sev.sigev_value.sival_ptr = NULL;
+        sev.sigev_value.sival_int = h;
 
         /* Create timer using system clock */
-        if (timer_create(CLOCK_REALTIME, &sev, &tidlist[j]) == -1)
+        if (timer_create(CLOCK_REALTIME, &sev, &rec->tid) == -1)
             errExit("timer_create");
+        PTMR_PROBE2(create, j + 1, (long)rec->tid);
 
-        printf("Timer %d created with ID: %ld\n", j + 1, (long)tidlist[j]);
+        printf("Timer %d created with ID: %ld\n", j + 1, (long)rec->tid);
 
         /* Arm (start) the timer */
-        if (timer_settime(tidlist[j], 0, &ts, NULL) == -1)
+        phaseAlign(j + 1, CLOCK_REALTIME, &ts);
+        if (timer_settime(rec->tid, absFlag ? TIMER_ABSTIME : 0, &ts, NULL) == -1)
             errExit("timer_settime");
+        PTMR_PROBE4(settime, j + 1, absFlag, PTMR_TS_NS(&ts.it_value),
+                    PTMR_TS_NS(&ts.it_interval));
     }
 
-    /* Infinite loop to wait for signals */
-    for (;;)
+    fflush(stdout);             /* From here on only eventWriter() prints */
+
+    /* Infinite loop to wait for signals; with -p each pause() is a batch
+       covering signal delivery and every handler() run it returns after */
+    perfStart(&perf, "posix");
+    for (;;) {
+        pcBegin(&perf);
         pause();
+        perfEnd(&perf, atomic_exchange_explicit(&handled, 0,
+                                                memory_order_relaxed), "posix");
+    }
+}
+
+/* One logical timer multiplexed onto the wheel */
+struct wheel_job {
+    struct tw_timer tmr;
+    int id;
+};
+
+/* Convert a timespec to wheel ticks, rounding up so nothing fires early */
+static uint64_t timespecToTicks(const struct timespec *tp)
+{
+    uint64_t ns = (uint64_t)tp->tv_sec * 1000000000 + tp->tv_nsec;
+
+    return (ns + WHEEL_TICK_NS - 1) / WHEEL_TICK_NS;
+}
+
+static uint64_t monotonicTicks(void)
+{
+    return monotonicNs() / WHEEL_TICK_NS;
+}
+
+/* Wheel callback: runs in normal context, so stdio is safe here */
+static void wheelExpire(struct tw_timer *t, uint64_t overrun)
+{
+    struct wheel_job *job = t->data;
+
+    noteExpiration(job->id, overrun);
+    printf("Wheel timer %d expired at %s\n", job->id, currTime("%T"));
+    printf("Overrun: %llu\n", (unsigned long long)overrun);
 }
 
+/* Wheel mode: every spec becomes a logical timer and a single kernel
+   timer ticks the wheel, so only one queued signal is ever preallocated */
+static void runWheel(int nspecs, char *specs[])
+{
+    static struct timer_wheel tw;
+    struct wheel_job *jobs;
+    struct itimerspec ts;
+    struct sigevent sev;
+    sigset_t mask;
+    siginfo_t si;
+    timer_t tick;
+    size_t n;
+    int j;
+
+    jobs = calloc(nspecs, sizeof(struct wheel_job));
+    if (jobs == NULL)
+        errExit("malloc");
+
+    /* Expirations are collected with sigwaitinfo(), not a handler */
+    sigemptyset(&mask);
+    sigaddset(&mask, TIMER_SIG);
+    if (sigprocmask(SIG_BLOCK, &mask, NULL) == -1)
+        errExit("sigprocmask");
+
+    twInit(&tw, monotonicTicks());
+
+    for (j = 0; j < nspecs; j++) {
+        itimerspecFromStr(specs[j], &ts);
+        notePeriod(j + 1, &ts);
+        printf("Setting timer with expiration: %ld sec and %ld nsec\n", ts.it_value.tv_sec, ts.it_value.tv_nsec);
+
+        jobs[j].id = j + 1;
+        twTimerInit(&jobs[j].tmr, wheelExpire, &jobs[j]);
+        twArm(&tw, &jobs[j].tmr, timespecToTicks(&ts.it_value),
+              timespecToTicks(&ts.it_interval));
+    }
+
+    /* The one kernel timer that drives every logical timer */
+    sev.sigev_notify = SIGEV_SIGNAL;
+    sev.sigev_signo = TIMER_SIG;
+    sev.sigev_value.sival_ptr = &tw;
+    if (timer_create(CLOCK_MONOTONIC, &sev, &tick) == -1)
+        errExit("timer_create");
+    PTMR_PROBE2(create, 0, (long)tick);
+
+    ts.it_value.tv_sec = 0;
+    ts.it_value.tv_nsec = WHEEL_TICK_NS;
+    ts.it_interval = ts.it_value;
+    if (timer_settime(tick, 0, &ts, NULL) == -1)
+        errExit("timer_settime");
+    PTMR_PROBE4(settime, 0, 0, PTMR_TS_NS(&ts.it_value),
+                PTMR_TS_NS(&ts.it_interval));
+
+    printf("%d timers multiplexed onto kernel timer %ld\n", nspecs, (long)tick);
+
+    /* Catch up to the clock on each tick; missed ticks need no special
+       handling because the wheel advances to the current time */
+    perfStart(&perf, "wheel");
+    for (;;) {
+        pcBegin(&perf);
+        if (sigwaitinfo(&mask, &si) == -1)
+            errExit("sigwaitinfo");
+        n = twAdvance(&tw, monotonicTicks());
+        perfEnd(&perf, n, "wheel");
+    }
+}
+
+/* One logical timer kept in the heap */
+struct heap_job {
+    struct th_timer tmr;
+    int id;
+};
+
+static void heapExpire(struct th_timer *t, uint64_t overrun)
+{
+    struct heap_job *job = t->data;
+
+    noteExpiration(job->id, overrun);
+    printf("Heap timer %d expired at %s\n", job->id, currTime("%T"));
+    printf("Overrun: %llu\n", (unsigned long long)overrun);
+}
+
+/* Heap mode: like wheel mode, but with no periodic tick. The single
+   kernel timer is re-armed as an absolute one-shot for the heap's
+   earliest deadline, so the process sleeps until something is due.
+   Specs with a "~slack" suffix are coalesced with nearby deadlines */
+static void runHeap(int nspecs, char *specs[])
+{
+    struct timer_heap th;
+    struct heap_job *jobs;
+    struct itimerspec ts;
+    struct timespec slack;
+    struct sigevent sev;
+    uint64_t now, next, statsStart;
+    unsigned long wakeups = 0, expirations = 0, n;
+    double secs;
+    sigset_t mask;
+    siginfo_t si;
+    timer_t kt;
+    int j;
+
+    jobs = calloc(nspecs, sizeof(struct heap_job));
+    if (jobs == NULL)
+        errExit("malloc");
+
+    sigemptyset(&mask);
+    sigaddset(&mask, TIMER_SIG);
+    if (sigprocmask(SIG_BLOCK, &mask, NULL) == -1)
+        errExit("sigprocmask");
+
+    thInit(&th);
+    now = monotonicNs();
+
+    for (j = 0; j < nspecs; j++) {
+        itimerspecSlackFromStr(specs[j], &ts, &slack);
+        notePeriod(j + 1, &ts);
+        printf("Setting timer with expiration: %ld sec and %ld nsec\n", ts.it_value.tv_sec, ts.it_value.tv_nsec);
+
+        jobs[j].id = j + 1;
+        thTimerInit(&jobs[j].tmr, heapExpire, &jobs[j]);
+        thSetSlack(&jobs[j].tmr, (uint64_t)slack.tv_sec * 1000000000 + slack.tv_nsec);
+
+        /* A zero it_value means disarmed, as with timer_settime() */
+        if (ts.it_value.tv_sec == 0 && ts.it_value.tv_nsec == 0)
+            continue;
+        if (thArm(&th, &jobs[j].tmr,
+                  now + (uint64_t)ts.it_value.tv_sec * 1000000000 + ts.it_value.tv_nsec,
+                  (uint64_t)ts.it_interval.tv_sec * 1000000000 + ts.it_interval.tv_nsec) == -1)
+            errExit("thArm");
+    }
+
+    sev.sigev_notify = SIGEV_SIGNAL;
+    sev.sigev_signo = TIMER_SIG;
+    sev.sigev_value.sival_ptr = &th;
+    if (timer_create(CLOCK_MONOTONIC, &sev, &kt) == -1)
+        errExit("timer_create");
+    PTMR_PROBE2(create, 0, (long)kt);
+
+    printf("%d timers multiplexed onto kernel timer %ld\n", nspecs, (long)kt);
+
+    ts.it_interval.tv_sec = 0;
+    ts.it_interval.tv_nsec = 0;
+    statsStart = monotonicNs();
+    perfStart(&perf, "heap");
+
+    for (;;) {
+        pcBegin(&perf);
+        next = thNextExpiry(&th);
+        if (next == UINT64_MAX)
+            break;                      /* Only one-shots, all expired */
+
+        ts.it_value.tv_sec = next / 1000000000;
+        ts.it_value.tv_nsec = next % 1000000000;
+        if (timer_settime(kt, TIMER_ABSTIME, &ts, NULL) == -1)
+            errExit("timer_settime");
+        PTMR_PROBE4(settime, 0, TIMER_ABSTIME, next, 0);
+
+        if (sigwaitinfo(&mask, &si) == -1) {
+            if (errno == EINTR)
+                continue;
+            errExit("sigwaitinfo");
+        }
+
+        now = monotonicNs();
+        wakeups++;
+        n = thAdvance(&th, now);
+        expirations += n;
+        perfEnd(&perf, n, "heap");
+
+        /* Without coalescing every expiration would be its own wakeup */
+        if (now - statsStart >= STATS_INTERVAL_NS) {
+            secs = (now - statsStart) / 1e9;
+            printf("Coalescing: %.1f wakeups/s for %.1f expirations/s (%.1f wakeups/s saved)\n",
+                   wakeups / secs, expirations / secs,
+                   (expirations - wakeups) / secs);
+            statsStart = now;
+            wakeups = 0;
+            expirations = 0;
+        }
+    }
+
+    printf("No timers left armed\n");
+}
+
+/* One IORING_OP_TIMEOUT request per command-line spec */
+struct uring_job {
+    struct __kernel_timespec ts;    /* Must outlive the submission */
+    uint64_t deadline;              /* Absolute CLOCK_MONOTONIC ns */
+    uint64_t interval;              /* Period in ns, 0 for one-shot */
+    int multishot;                  /* Armed as a multishot timeout */
+    int id;
+};
+
+static int uringMultishot = 1;  /* Cleared if the kernel rejects it */
+
+static void uringQueue(struct io_ring *ring, struct uring_job *job)
+{
+    struct io_uring_sqe *sqe;
+
+    sqe = irGetSqe(ring);
+    if (sqe == NULL) {
+        /* Make room by submitting what is already queued */
+        if (irSubmitAndWait(ring, 0) == -1)
+            errExit("io_uring_enter");
+        sqe = irGetSqe(ring);
+    }
+
+    sqe->opcode = IORING_OP_TIMEOUT;
+    sqe->fd = -1;
+    sqe->addr = (uintptr_t)&job->ts;
+    sqe->len = 1;
+    sqe->off = 0;               /* Pure timeout: ignore other completions */
+    sqe->user_data = (uintptr_t)job;
+
+    if (job->multishot) {
+        /* Relative period, repeated by the kernel with no new SQEs */
+        job->ts.tv_sec = job->interval / 1000000000;
+        job->ts.tv_nsec = job->interval % 1000000000;
+        sqe->timeout_flags = IORING_TIMEOUT_MULTISHOT;
+    } else {
+        job->ts.tv_sec = job->deadline / 1000000000;
+        job->ts.tv_nsec = job->deadline % 1000000000;
+        sqe->timeout_flags = IORING_TIMEOUT_ABS;
+    }
+}
+
+/* io_uring mode: expirations arrive as CQEs (res == -ETIME) in the same
+   completion queue as any other I/O. A periodic timer is switched to a
+   multishot timeout after its first expiration, so once the ring is warm
+   it costs no submissions; kernels without multishot support fall back
+   to re-queueing absolute one-shots on the timer's period grid */
+static void runUring(int nspecs, char *specs[])
+{
+    struct io_ring ring;
+    struct io_uring_cqe *cqe;
+    struct uring_job *jobs, *job;
+    struct itimerspec ts;
+    uint64_t now, overrun;
+    unsigned flags;
+    int res, n, j;
+
+    jobs = calloc(nspecs, sizeof(struct uring_job));
+    if (jobs == NULL)
+        errExit("malloc");
+
+    if (irInit(&ring, URING_ENTRIES) == -1)
+        errExit("io_uring_setup");
+
+    now = monotonicNs();
+
+    for (j = 0; j < nspecs; j++) {
+        itimerspecFromStr(specs[j], &ts);
+        notePeriod(j + 1, &ts);
+        printf("Setting timer with expiration: %ld sec and %ld nsec\n", ts.it_value.tv_sec, ts.it_value.tv_nsec);
+
+        jobs[j].id = j + 1;
+        jobs[j].interval = (uint64_t)ts.it_interval.tv_sec * 1000000000 + ts.it_interval.tv_nsec;
+        jobs[j].deadline = now + (uint64_t)ts.it_value.tv_sec * 1000000000 + ts.it_value.tv_nsec;
+
+        /* A zero it_value means disarmed, as with timer_settime() */
+        if (ts.it_value.tv_sec == 0 && ts.it_value.tv_nsec == 0)
+            continue;
+        uringQueue(&ring, &jobs[j]);
+    }
+
+    perfStart(&perf, "uring");
+    for (;;) {
+        pcBegin(&perf);
+        if (irSubmitAndWait(&ring, 1) == -1)
+            errExit("io_uring_enter");
+
+        for (n = 0; (cqe = irPeekCqe(&ring)) != NULL; n++) {
+            job = (struct uring_job *)(uintptr_t)cqe->user_data;
+            res = cqe->res;
+            flags = cqe->flags;
+            irCqeSeen(&ring);
+
+            if (res == -EINVAL && job->multishot) {
+                /* Kernel predates multishot timeouts */
+                uringMultishot = 0;
+                job->multishot = 0;
+                job->deadline = monotonicNs() + job->interval;
+                uringQueue(&ring, job);
+                continue;
+            }
+
+            if (res != -ETIME) {
+                errno = -res;
+                errExit("IORING_OP_TIMEOUT");
+            }
+
+            now = monotonicNs();
+            overrun = 0;
+
+            if (job->interval != 0) {
+                /* Stay on the period grid, folding missed periods into
+                   the overrun; a multishot timeout skips them the same
+                   way, posting one CQE for the next period it reaches */
+                if (now > job->deadline)
+                    overrun = (now - job->deadline) / job->interval;
+                job->deadline += (overrun + 1) * job->interval;
+
+                if (job->multishot) {
+                    /* Re-arm only if the kernel ended the multishot */
+                    if (!(flags & IORING_CQE_F_MORE))
+                        uringQueue(&ring, job);
+                } else {
+                    job->multishot = uringMultishot;
+                    uringQueue(&ring, job);
+                }
+            }
+
+            noteExpiration(job->id, overrun);
+            printf("Timer %d expired at %s\n", job->id, currTime("%T"));
+            printf("Overrun: %llu\n", (unsigned long long)overrun);
+        }
+        perfEnd(&perf, n, "uring");
+    }
+}
+
+/* One timerfd per command-line spec */
+struct fd_job {
+    int fd;
+    int id;
+};
+
+/* timerfd mode: expirations are read from descriptors in normal thread
+   context, so there is no signal frame and no interrupted syscall */
+static void runTimerfd(int nspecs, char *specs[])
+{
+    struct epoll_event ev, evlist[MAX_EVENTS];
+    struct itimerspec ts;
+    struct fd_job *jobs, *job;
+    uint64_t expirations;
+    int epfd, ready, j;
+
+    jobs = calloc(nspecs, sizeof(struct fd_job));
+    if (jobs == NULL)
+        errExit("malloc");
+
+    epfd = epoll_create1(EPOLL_CLOEXEC);
+    if (epfd == -1)
+        errExit("epoll_create1");
+
+    for (j = 0; j < nspecs; j++) {
+        itimerspecFromStr(specs[j], &ts);
+        notePeriod(j + 1, &ts);
+        printf("Setting timer with expiration: %ld sec and %ld nsec\n", ts.it_value.tv_sec, ts.it_value.tv_nsec);
+
+        jobs[j].id = j + 1;
+        jobs[j].fd = timerfd_create(CLOCK_REALTIME, TFD_NONBLOCK | TFD_CLOEXEC);
+        if (jobs[j].fd == -1)
+            errExit("timerfd_create");
+        PTMR_PROBE2(create, j + 1, (long)jobs[j].fd);
+
+        ev.events = EPOLLIN;
+        ev.data.ptr = &jobs[j];
+        if (epoll_ctl(epfd, EPOLL_CTL_ADD, jobs[j].fd, &ev) == -1)
+            errExit("epoll_ctl");
+
+        printf("Timer %d created with fd: %d\n", j + 1, jobs[j].fd);
+
+        phaseAlign(j + 1, CLOCK_REALTIME, &ts);
+        if (timerfd_settime(jobs[j].fd, absFlag ? TFD_TIMER_ABSTIME : 0, &ts, NULL) == -1)
+            errExit("timerfd_settime");
+        PTMR_PROBE4(settime, j + 1, absFlag, PTMR_TS_NS(&ts.it_value),
+                    PTMR_TS_NS(&ts.it_interval));
+    }
+
+    perfStart(&perf, "timerfd");
+    for (;;) {
+        pcBegin(&perf);
+        ready = epoll_wait(epfd, evlist, MAX_EVENTS, -1);
+        if (ready == -1) {
+            if (errno == EINTR)
+                continue;
+            errExit("epoll_wait");
+        }
+
+        for (j = 0; j < ready; j++) {
+            job = evlist[j].data.ptr;
+
+            /* The 8-byte count covers every expiration since the last
+               read, so anything beyond the first is an overrun */
+            if (read(job->fd, &expirations, sizeof(expirations)) !=
+                    sizeof(expirations)) {
+                if (errno == EAGAIN)
+                    continue;
+                errExit("read");
+            }
+
+            noteExpiration(job->id, expirations - 1);
+            printf("Timer %d expired at %s\n", job->id, currTime("%T"));
+            printf("Overrun: %llu\n", (unsigned long long)(expirations - 1));
+        }
+        perfEnd(&perf, ready, "timerfd");
+    }
+}
+
+/* signalfd mode: same kernel timers as the default mode, but TIMER_SIG
+   stays blocked and queued expirations are drained in batches, so a
+   burst of N expirations costs one read() instead of N handler calls */
+static void runSignalfd(int nspecs, char *specs[])
+{
+    struct signalfd_siginfo fdsi[MAX_SIGINFO];
+    struct itimerspec ts;
+    struct sigevent sev;
+    struct tp_record *rec;
+    tp_handle h;
+    sigset_t mask;
+    ssize_t numRead;
+    int sfd, nrec, j, id;
+
+    if (tpInit(&pool, nspecs) == -1)
+        errExit("tpInit");
+
+    sigemptyset(&mask);
+    sigaddset(&mask, TIMER_SIG);
+    if (sigprocmask(SIG_BLOCK, &mask, NULL) == -1)
+        errExit("sigprocmask");
+
+    sfd = signalfd(-1, &mask, SFD_CLOEXEC);
+    if (sfd == -1)
+        errExit("signalfd");
+
+    sev.sigev_notify = SIGEV_SIGNAL;
+    sev.sigev_signo = TIMER_SIG;
+
+    for (j = 0; j < nspecs; j++) {
+        itimerspecFromStr(specs[j], &ts);
+        notePeriod(j + 1, &ts);
+        printf("Setting timer with expiration: %ld sec and %ld nsec\n", ts.it_value.tv_sec, ts.it_value.tv_nsec);
+
+        h = tpAlloc(&pool);
+        if (h == TP_INVALID)
+            usageErr("Timer pool exhausted at spec %d\n", j + 1);
+        rec = tpLookup(&pool, h);
+        rec->id = j + 1;
+        rec->periodic = ts.it_interval.tv_sec != 0 || ts.it_interval.tv_nsec != 0;
+
+        /* Each timer owns its queued signal, so even a standard signal
+           such as SIGUSR1 is queued once per timer, not merged */
+        sev.sigev_value.sival_ptr = NULL;
+        sev.sigev_value.sival_int = h;
+        if (timer_create(CLOCK_REALTIME, &sev, &rec->tid) == -1)
+            errExit("timer_create");
+        PTMR_PROBE2(create, j + 1, (long)rec->tid);
+
+        printf("Timer %d created with ID: %ld\n", j + 1, (long)rec->tid);
+
+        phaseAlign(j + 1, CLOCK_REALTIME, &ts);
+        if (timer_settime(rec->tid, absFlag ? TIMER_ABSTIME : 0, &ts, NULL) == -1)
+            errExit("timer_settime");
+        PTMR_PROBE4(settime, j + 1, absFlag, PTMR_TS_NS(&ts.it_value),
+                    PTMR_TS_NS(&ts.it_interval));
+    }
+
+    perfStart(&perf, "signalfd");
+    for (;;) {
+        pcBegin(&perf);
+        numRead = read(sfd, fdsi, sizeof(fdsi));
+        if (numRead == -1) {
+            if (errno == EINTR)
+                continue;
+            errExit("read");
+        }
+
+        nrec = numRead / sizeof(struct signalfd_siginfo);
+        printf("Drained %d expiration(s) at %s\n", nrec, currTime("%T"));
+
+        for (j = 0; j < nrec; j++) {
+            /* ssi_int carries the handle; ssi_overrun replaces the
+               timer_getoverrun() call made by handler() */
+            h = fdsi[j].ssi_int;
+            rec = tpLookup(&pool, h);
+            if (rec == NULL) {
+                printf("Stale expiration for handle %#x ignored\n", (unsigned)h);
+                continue;
+            }
+
+            noteExpiration(rec->id, fdsi[j].ssi_overrun);
+            printf("Timer ID: %ld\n", (long)rec->tid);
+            printf("Overrun: %u\n", fdsi[j].ssi_overrun);
+
+            /* A one-shot timer is finished: delete it and recycle its
+               record; its handle can no longer resolve */
+            if (!rec->periodic) {
+                id = rec->id;   /* 'rec' is recycled by tpRelease() */
+                if (timer_delete(rec->tid) == -1)
+                    errExit("timer_delete");
+                PTMR_PROBE2(delete, id, (long)rec->tid);
+                tpRelease(&pool, h);
+                printf("Timer %d deleted, %u timer(s) left\n", id, pool.live);
+            }
+        }
+        perfEnd(&perf, nrec, "signalfd");
+    }
+}
+
+/* A dispatcher thread pinned to one CPU, owning every nworkers'th spec */
+struct cpu_worker {
+    pthread_t thread;
+    int cpu;
+    int index;
+    int nworkers;
+    int nspecs;
+    char **specs;
+};
+
+static void *cpuWorker(void *arg)
+{
+    struct cpu_worker *w = arg;
+    struct timer_pool wpool;    /* This worker's shard of timer records */
+    struct tp_record *rec;
+    struct perf_counters wperf;
+    struct itimerspec ts;
+    struct sigevent sev;
+    char label[32];
+    cpu_set_t set;
+    sigset_t mask;
+    siginfo_t si;
+    tp_handle h;
+    int njobs, s, j;
+
+    CPU_ZERO(&set);
+    CPU_SET(w->cpu, &set);
+    s = pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+    if (s != 0) {
+        errno = s;
+        errExit("pthread_setaffinity_np");
+    }
+
+    /* Allocate the shard only after pinning, so its pages are touched
+       first from (and placed near) the CPU that will dispatch them. Each
+       worker owns its pool, so no locking is needed around it */
+    njobs = (w->nspecs - w->index + w->nworkers - 1) / w->nworkers;
+    if (tpInit(&wpool, njobs) == -1)
+        errExit("tpInit");
+
+    /* Each timer signals this thread, not the process as a whole */
+    sev.sigev_notify = SIGEV_THREAD_ID;
+    sev.sigev_signo = TIMER_SIG;
+    sev.sigev_notify_thread_id = gettid();
+
+    for (j = w->index; j < w->nspecs; j += w->nworkers) {
+        itimerspecFromStr(w->specs[j], &ts);
+        notePeriod(j + 1, &ts);
+
+        h = tpAlloc(&wpool);
+        if (h == TP_INVALID)
+            usageErr("Timer pool exhausted at spec %d\n", j + 1);
+        rec = tpLookup(&wpool, h);
+        rec->id = j + 1;
+        rec->periodic = ts.it_interval.tv_sec != 0 || ts.it_interval.tv_nsec != 0;
+        sev.sigev_value.sival_ptr = NULL;
+        sev.sigev_value.sival_int = h;
+        if (timer_create(CLOCK_REALTIME, &sev, &rec->tid) == -1)
+            errExit("timer_create");
+        PTMR_PROBE2(create, j + 1, (long)rec->tid);
+
+        printf("Timer %d created on CPU %d with ID: %ld\n", j + 1, w->cpu, (long)rec->tid);
+
+        phaseAlign(j + 1, CLOCK_REALTIME, &ts);
+        if (timer_settime(rec->tid, absFlag ? TIMER_ABSTIME : 0, &ts, NULL) == -1)
+            errExit("timer_settime");
+        PTMR_PROBE4(settime, j + 1, absFlag, PTMR_TS_NS(&ts.it_value),
+                    PTMR_TS_NS(&ts.it_interval));
+    }
+
+    /* TIMER_SIG is already blocked (inherited from main) */
+    sigemptyset(&mask);
+    sigaddset(&mask, TIMER_SIG);
+
+    /* Counters are per thread, so each worker keeps its own */
+    snprintf(label, sizeof(label), "percpu/cpu%d", w->cpu);
+    perfStart(&wperf, label);
+
+    for (;;) {
+        pcBegin(&wperf);
+        if (sigwaitinfo(&mask, &si) == -1) {
+            if (errno == EINTR)
+                continue;
+            errExit("sigwaitinfo");
+        }
+
+        /* A stale handle means the timer went away after this
+           expiration was queued */
+        rec = tpLookup(&wpool, si.si_value.sival_int);
+        if (rec == NULL)
+            continue;
+
+        noteExpiration(rec->id, si.si_overrun);
+        printf("CPU %d: timer %d expired at %s\n", sched_getcpu(), rec->id, currTime("%T"));
+        printf("Overrun: %d\n", si.si_overrun);
+        perfEnd(&wperf, 1, label);
+    }
+
+    return NULL;
+}
+
+/* Per-CPU mode: one pinned worker per usable CPU, each creating its share
+   of the timers with SIGEV_THREAD_ID so that expirations are dispatched
+   on the core that owns the timer's data */
+static void runPerCpu(int nspecs, char *specs[])
+{
+    struct cpu_worker *workers;
+    cpu_set_t avail;
+    sigset_t mask;
+    int nworkers, cpu, s, j;
+
+    if (sched_getaffinity(0, sizeof(avail), &avail) == -1)
+        errExit("sched_getaffinity");
+
+    nworkers = CPU_COUNT(&avail);
+    if (nworkers > nspecs)
+        nworkers = nspecs;
+
+    workers = calloc(nworkers, sizeof(struct cpu_worker));
+    if (workers == NULL)
+        errExit("malloc");
+
+    /* Block before spawning so every worker inherits the mask */
+    sigemptyset(&mask);
+    sigaddset(&mask, TIMER_SIG);
+    s = pthread_sigmask(SIG_BLOCK, &mask, NULL);
+    if (s != 0) {
+        errno = s;
+        errExit("pthread_sigmask");
+    }
+
+    for (j = 0, cpu = 0; j < nworkers; cpu++) {
+        if (!CPU_ISSET(cpu, &avail))
+            continue;
+
+        workers[j].cpu = cpu;
+        workers[j].index = j;
+        workers[j].nworkers = nworkers;
+        workers[j].nspecs = nspecs;
+        workers[j].specs = specs;
+
+        s = pthread_create(&workers[j].thread, NULL, cpuWorker, &workers[j]);
+        if (s != 0) {
+            errno = s;
+            errExit("pthread_create");
+        }
+        j++;
+    }
+
+    printf("%d timers sharded across %d CPU worker(s)\n", nspecs, nworkers);
+
+    for (j = 0; j < nworkers; j++)
+        pthread_join(workers[j].thread, NULL);
+}
+
+/* -f: append the whitespace-separated specs in 'path' (e.g. written by
+   workload_gen -s) to the 'n' specs in '*specs' */
+static void loadSpecs(const char *path, char ***specs, int *n)
+{
+    char **list, word[128];
+    int cap = *n + 1024;
+    FILE *fp;
+
+    list = malloc(cap * sizeof(char *));
+    if (list == NULL)
+        errExit("malloc");
+    memcpy(list, *specs, *n * sizeof(char *));
+
+    fp = fopen(path, "r");
+    if (fp == NULL)
+        errExit(path);
+
+    while (fscanf(fp, "%127s", word) == 1) {
+        if (*n == cap) {
+            cap *= 2;
+            list = realloc(list, cap * sizeof(char *));
+            if (list == NULL)
+                errExit("realloc");
+        }
+        list[*n] = strdup(word);
+        if (list[(*n)++] == NULL)
+            errExit("strdup");
+    }
+
+    fclose(fp);
+    *specs = list;
+}
+
+int main(int argc, char *argv[])
+{
+    const char *backend = "posix";
+    pthread_t reporter, watcher, waiter;
+    static sigset_t stop;               /* Read by stopWaiter() */
+    sigset_t mask, prevMask;
+    const char *traceFile = NULL, *specFile = NULL;
+    char **specs;
+    int opt, reportSecs = 0, nspecs, s;
+
+    while ((opt = getopt(argc, argv, "ab:f:mo:pt:")) != -1) {
+        switch (opt) {
+        case 'a':
+            absFlag = 1;
+            break;
+        case 'f':
+            specFile = optarg;
+            break;
+        case 'm':
+            metricsFlag = 1;
+            break;
+        case 'p':
+            perfFlag = 1;
+            break;
+        case 't':
+            traceFile = optarg;
+            break;
+        case 'o':
+            reportSecs = atoi(optarg);
+            break;
+        case 'b':
+            backend = optarg;
+            break;
+        default:
+            usageErr(USAGE, argv[0]);
+        }
+    }
+
+    specs = &argv[optind];
+    nspecs = argc - optind;
+    if (specFile != NULL)
+        loadSpecs(specFile, &specs, &nspecs);
+
+    if (nspecs == 0)
+        usageErr(USAGE, argv[0]);
+
+    if (osInit(&ostats, nspecs) == -1)
+        errExit("osInit");
+    deadlines = calloc(nspecs, sizeof(struct deadline));
+    if (deadlines == NULL)
+        errExit("calloc");
+
+    if (traceFile != NULL && etCreate(&trace, traceFile, TRACE_BYTES) == -1)
+        errExit(traceFile);
+
+    /* Lateness is measured with the TSC where it can be trusted */
+    if ((metricsFlag || traceFile != NULL) && !tcInit(&tsc))
+        fprintf(stderr, "Timestamps from clock_gettime(): %s\n", tsc.why);
+
+    if (metricsFlag) {
+        startMetrics(backend);
+    } else if (traceFile != NULL) {
+        /* Only stopWaiter() takes SIGINT/SIGTERM, so the trace is closed;
+           threads created later inherit the mask */
+        sigemptyset(&stop);
+        sigaddset(&stop, SIGINT);
+        sigaddset(&stop, SIGTERM);
+        pthread_sigmask(SIG_BLOCK, &stop, NULL);
+
+        sigemptyset(&mask);
+        sigaddset(&mask, TIMER_SIG);
+        pthread_sigmask(SIG_BLOCK, &mask, &prevMask);
+        s = pthread_create(&waiter, NULL, stopWaiter, &stop);
+        if (s != 0) {
+            errno = s;
+            errExit("pthread_create");
+        }
+        pthread_sigmask(SIG_SETMASK, &prevMask, NULL);
+    }
+
+    /* -a: REALTIME deadlines go through the cached offset (phaseAlign());
+       with -m/-t they follow clock steps (rebaseDeadline()) */
+    if (absFlag && coInit(&clockOffset) == -1)
+        errExit("coInit");
+    if (absFlag && (metricsFlag || traceFile != NULL)) {
+        sigemptyset(&mask);
+        sigaddset(&mask, TIMER_SIG);
+        pthread_sigmask(SIG_BLOCK, &mask, &prevMask);
+        s = pthread_create(&watcher, NULL, clockWatcher, NULL);
+        if (s != 0) {
+            errno = s;
+            errExit("pthread_create");
+        }
+        pthread_sigmask(SIG_SETMASK, &prevMask, NULL);
+    }
+
+    if (reportSecs > 0) {
+        /* Keep TIMER_SIG away from the reporter thread */
+        sigemptyset(&mask);
+        sigaddset(&mask, TIMER_SIG);
+        pthread_sigmask(SIG_BLOCK, &mask, &prevMask);
+        s = pthread_create(&reporter, NULL, overrunReporter,
+                           (void *)(intptr_t)reportSecs);
+        if (s != 0) {
+            errno = s;
+            errExit("pthread_create");
+        }
+        pthread_sigmask(SIG_SETMASK, &prevMask, NULL);
+    }
+
+    if (strcmp(backend, "posix") == 0)
+        runPosixTimers(nspecs, specs);
+    else if (strcmp(backend, "wheel") == 0)
+        runWheel(nspecs, specs);
+    else if (strcmp(backend, "timerfd") == 0)
+        runTimerfd(nspecs, specs);
+    else if (strcmp(backend, "signalfd") == 0)
+        runSignalfd(nspecs, specs);
+    else if (strcmp(backend, "percpu") == 0)
+        runPerCpu(nspecs, specs);
+    else if (strcmp(backend, "heap") == 0)
+        runHeap(nspecs, specs);
+    else if (strcmp(backend, "uring") == 0)
+        runUring(nspecs, specs);
+    else
+        usageErr("%s: unknown backend '%s'\n", argv[0], backend);
+
+    shutdownAndExit();
+}
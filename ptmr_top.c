@@ -0,0 +1,102 @@
+#define _GNU_SOURCE
+#include <signal.h>
+#include <time.h>
+#include "metrics_shm.h"    /* Live metrics published by the driver */
+#include "tlpi_hdr.h"       /* Error handling functions */
+
+/*
+ * Top-style viewer for the metrics that "ptmr_sigev_signal -m" publishes
+ * in shared memory. The segment is mapped read-only and sampled with the
+ * sequence lock, so watching a process never slows it down. With -n the
+ * view is printed that many times without clearing the screen (for logs).
+ */
+
+#define USAGE "%s [-d delay-secs] [-n iterations] pid\n"
+
+static uint64_t monotonicNs(void)
+{
+    struct timespec ts;
+
+    if (clock_gettime(CLOCK_MONOTONIC, &ts) == -1)
+        errExit("clock_gettime");
+    return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static void show(const struct ms_snapshot *snap, int clear)
+{
+    uint64_t age;
+
+    if (clear)
+        printf("\033[H\033[2J");
+
+    age = snap->updated ? (monotonicNs() - snap->updated) / 1000000 : 0;
+    printf("ptmr_top - pid %d, backend %s, updated %llu ms ago%s\n\n",
+           (int)snap->pid, snap->backend, (unsigned long long)age,
+           (snap->updated == 0 || age > 3 * snap->period) ? " (not updating)" : "");
+
+    printf("  active timers   %12llu\n", (unsigned long long)snap->activeTimers);
+    printf("  expirations/s   %12.1f\n", snap->expirationsPerSec);
+    printf("  notifications   %12llu\n", (unsigned long long)snap->expirations);
+    printf("  overruns        %12llu\n", (unsigned long long)snap->overruns);
+    printf("  queue depth     %12llu\n\n", (unsigned long long)snap->queueDepth);
+
+    printf("  dispatch latency over the last %u ms (%llu samples)\n",
+           snap->period, (unsigned long long)snap->latencySamples);
+    printf("  %10s %10s %10s %10s   (us)\n", "p50", "p99", "p99.9", "max");
+    printf("  %10.1f %10.1f %10.1f %10.1f\n", snap->latencyP50 / 1000.0,
+           snap->latencyP99 / 1000.0, snap->latencyP999 / 1000.0,
+           snap->latencyMax / 1000.0);
+    fflush(stdout);
+}
+
+int main(int argc, char *argv[])
+{
+    const struct ms_segment *seg;
+    struct ms_snapshot snap;
+    struct timespec delay = { 1, 0 };
+    char name[MS_NAME_MAX];
+    long iterations = -1;
+    pid_t pid;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "d:n:")) != -1) {
+        switch (opt) {
+        case 'd':
+            delay.tv_sec = atoi(optarg);
+            break;
+        case 'n':
+            iterations = atol(optarg);
+            break;
+        default:
+            usageErr(USAGE, argv[0]);
+        }
+    }
+
+    if (optind != argc - 1 || delay.tv_sec <= 0)
+        usageErr(USAGE, argv[0]);
+
+    pid = atoi(argv[optind]);
+    if (pid <= 0)
+        usageErr(USAGE, argv[0]);
+
+    msName(name, sizeof(name), pid);
+    seg = msAttach(name);
+    if (seg == NULL)
+        errExit(name);
+
+    for (; iterations != 0; iterations--) {
+        msRead(seg, &snap);
+        show(&snap, iterations < 0);
+
+        /* The driver removes the segment when it exits */
+        if (kill(snap.pid, 0) == -1 && errno == ESRCH) {
+            printf("Process %d has exited\n", (int)snap.pid);
+            break;
+        }
+        if (iterations != 1)
+            nanosleep(&delay, NULL);
+    }
+
+    msDetach(seg);
+    exit(EXIT_SUCCESS);
+}
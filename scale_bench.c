@@ -0,0 +1,250 @@
+#define _GNU_SOURCE
+#include <signal.h>
+#include <stdint.h>
+#include <sys/resource.h>
+#include <time.h>
+#include "timer_heap.h"     /* User-space 4-ary min-heap timer queue */
+#include "timer_wheel.h"    /* User-space hierarchical timing wheel */
+#include "tlpi_hdr.h"       /* Error handling functions */
+
+/*
+ * Sweeps the timer population from 1 up to a maximum (x10 per step) and
+ * reports, for kernel POSIX timers and for the user-space engines, how
+ * many create/arm/delete operations per second each achieves and how
+ * much memory each timer costs. Kernel timers are created the way
+ * ptmr_sigev_signal.c creates them; when timer_create() fails with
+ * EAGAIN the RLIMIT_SIGPENDING ceiling is reported instead of exiting.
+ */
+
+#define TIMER_SIG SIGUSR1
+#define FAR_AWAY  3600          /* Arm timers an hour out: none expire */
+
+static uint64_t nowNs(void)
+{
+    struct timespec ts;
+
+    if (clock_gettime(CLOCK_MONOTONIC, &ts) == -1)
+        errExit("clock_gettime");
+    return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+/* Resident set size of this process, in bytes */
+static long rssBytes(void)
+{
+    long size, resident = 0;
+    FILE *fp;
+
+    fp = fopen("/proc/self/statm", "r");
+    if (fp == NULL)
+        return 0;
+    if (fscanf(fp, "%ld %ld", &size, &resident) != 2)
+        resident = 0;
+    fclose(fp);
+    return resident * sysconf(_SC_PAGESIZE);
+}
+
+/* Unreclaimable kernel slab memory (system wide), in bytes */
+static long slabBytes(void)
+{
+    char line[128];
+    long kb = 0;
+    FILE *fp;
+
+    fp = fopen("/proc/meminfo", "r");
+    if (fp == NULL)
+        return 0;
+    while (fgets(line, sizeof(line), fp) != NULL)
+        if (sscanf(line, "SUnreclaim: %ld kB", &kb) == 1)
+            break;
+    fclose(fp);
+    return kb * 1024;
+}
+
+static double perSec(long ops, uint64_t ns)
+{
+    return ns ? ops * 1e9 / ns : 0.0;
+}
+
+static void printRow(const char *backend, long n, uint64_t createNs,
+                     uint64_t armNs, uint64_t deleteNs, long rss, long slab)
+{
+    printf("%-8s %9ld %12.0f %12.0f %12.0f %10.1f %10.1f\n", backend, n,
+           perSec(n, createNs), perSec(n, armNs), perSec(n, deleteNs),
+           (double)rss / n, (double)slab / n);
+    fflush(stdout);
+}
+
+/* Returns the number of timers actually created (< n at the ceiling) */
+static long benchKernel(long n)
+{
+    struct itimerspec ts;
+    struct sigevent sev;
+    timer_t *tids;
+    uint64_t t0, t1, t2, t3;
+    long rss0, slab0, rss, slab, j, created;
+
+    rss0 = rssBytes();
+    slab0 = slabBytes();
+
+    tids = calloc(n, sizeof(timer_t));
+    if (tids == NULL)
+        errExit("malloc");
+
+    sev.sigev_notify = SIGEV_SIGNAL;
+    sev.sigev_signo = TIMER_SIG;
+
+    t0 = nowNs();
+    for (created = 0; created < n; created++) {
+        sev.sigev_value.sival_ptr = &tids[created];
+        if (timer_create(CLOCK_REALTIME, &sev, &tids[created]) == -1) {
+            if (errno == EAGAIN)
+                break;          /* Out of preallocated queued signals */
+            errExit("timer_create");
+        }
+    }
+    t1 = nowNs();
+
+    ts.it_value.tv_sec = FAR_AWAY;
+    ts.it_value.tv_nsec = 0;
+    ts.it_interval.tv_sec = 0;
+    ts.it_interval.tv_nsec = 0;
+    for (j = 0; j < created; j++)
+        if (timer_settime(tids[j], 0, &ts, NULL) == -1)
+            errExit("timer_settime");
+    t2 = nowNs();
+
+    rss = rssBytes() - rss0;
+    slab = slabBytes() - slab0;
+
+    for (j = 0; j < created; j++)
+        if (timer_delete(tids[j]) == -1)
+            errExit("timer_delete");
+    t3 = nowNs();
+
+    free(tids);
+
+    if (created > 0)
+        printRow("kernel", created, t1 - t0, t2 - t1, t3 - t2, rss, slab);
+    return created;
+}
+
+static void noExpire(struct tw_timer *t, uint64_t overrun)
+{
+}
+
+static void benchWheel(long n)
+{
+    static struct timer_wheel tw;
+    struct tw_timer *timers;
+    uint64_t t0, t1, t2, t3;
+    long rss0, rss, j;
+
+    rss0 = rssBytes();
+    twInit(&tw, 0);
+
+    t0 = nowNs();
+    timers = malloc(n * sizeof(struct tw_timer));
+    if (timers == NULL)
+        errExit("malloc");
+    for (j = 0; j < n; j++)
+        twTimerInit(&timers[j], noExpire, NULL);
+    t1 = nowNs();
+
+    /* Spread over every level, as real timeouts would be */
+    for (j = 0; j < n; j++)
+        twArm(&tw, &timers[j], 1 + (j * 2654435761u) % 100000000, 0);
+    t2 = nowNs();
+
+    rss = rssBytes() - rss0;
+
+    for (j = 0; j < n; j++)
+        twCancel(&tw, &timers[j]);
+    t3 = nowNs();
+
+    free(timers);
+    printRow("wheel", n, t1 - t0, t2 - t1, t3 - t2, rss, 0);
+}
+
+static void noExpireHeap(struct th_timer *t, uint64_t overrun)
+{
+}
+
+static void benchHeap(long n)
+{
+    struct timer_heap th;
+    struct th_timer *timers;
+    uint64_t t0, t1, t2, t3;
+    long rss0, rss, j;
+
+    rss0 = rssBytes();
+    thInit(&th);
+
+    t0 = nowNs();
+    timers = malloc(n * sizeof(struct th_timer));
+    if (timers == NULL)
+        errExit("malloc");
+    for (j = 0; j < n; j++)
+        thTimerInit(&timers[j], noExpireHeap, NULL);
+    t1 = nowNs();
+
+    for (j = 0; j < n; j++)
+        if (thArm(&th, &timers[j],
+                  1 + (j * 2654435761u) % 100000000000ULL, 0) == -1)
+            errExit("thArm");
+    t2 = nowNs();
+
+    rss = rssBytes() - rss0;
+
+    /* Cancel in creation order, i.e. from arbitrary heap positions */
+    for (j = 0; j < n; j++)
+        thCancel(&th, &timers[j]);
+    t3 = nowNs();
+
+    thFree(&th);
+    free(timers);
+    printRow("heap", n, t1 - t0, t2 - t1, t3 - t2, rss, 0);
+}
+
+int main(int argc, char *argv[])
+{
+    struct rlimit rl;
+    sigset_t mask;
+    long max = 1000000, n, created;
+    int kernelDone = 0;
+
+    if (argc > 2 || (argc == 2 && strcmp(argv[1], "--help") == 0))
+        usageErr("%s [max-timers]\n", argv[0]);
+    if (argc == 2)
+        max = atol(argv[1]);
+
+    /* Nothing should expire, but never let a stray signal kill us */
+    sigemptyset(&mask);
+    sigaddset(&mask, TIMER_SIG);
+    if (sigprocmask(SIG_BLOCK, &mask, NULL) == -1)
+        errExit("sigprocmask");
+
+    if (getrlimit(RLIMIT_SIGPENDING, &rl) == -1)
+        errExit("getrlimit");
+    if (rl.rlim_cur == RLIM_INFINITY)
+        printf("RLIMIT_SIGPENDING: unlimited\n");
+    else
+        printf("RLIMIT_SIGPENDING: %llu\n", (unsigned long long)rl.rlim_cur);
+
+    printf("%-8s %9s %12s %12s %12s %10s %10s\n", "backend", "timers",
+           "create/s", "arm/s", "delete/s", "rss-B/tmr", "slab-B/tmr");
+
+    for (n = 1; n <= max; n *= 10) {
+        if (!kernelDone) {
+            created = benchKernel(n);
+            if (created < n) {
+                printf("kernel   ceiling reached: timer_create() failed with EAGAIN after %ld timers\n",
+                       created);
+                kernelDone = 1;
+            }
+        }
+        benchWheel(n);
+        benchHeap(n);
+    }
+
+    exit(EXIT_SUCCESS);
+}
@@ -0,0 +1,228 @@
+// timer_heap.c
+#include <stdlib.h>
+#include <string.h>
+#include "timer_heap.h"
+
+#define TH_CACHE_LINE 64
+
+/* Entries before logical index 0, so that every group of siblings
+   (4i+1 .. 4i+4) starts on a cache-line boundary */
+#define TH_PAD (TH_ARITY - 1)
+
+/* Latest-aligned key within [expires, expires + slack]: rounding up to a
+   power-of-two grid makes nearby deadlines collapse onto the same key */
+static uint64_t thCoalesce(uint64_t expires, uint64_t slack)
+{
+    uint64_t grain = 1, key;
+
+    if (slack == 0)
+        return expires;
+
+    while (grain <= slack / 2)
+        grain <<= 1;
+
+    key = (expires + grain - 1) & ~(grain - 1);
+    return key < expires ? expires : key;       /* Overflow near the top */
+}
+
+static void thPlace(struct timer_heap *h, size_t i, struct th_entry e)
+{
+    h->entries[i] = e;
+    e.timer->index = i;
+}
+
+static void thSiftUp(struct timer_heap *h, size_t i)
+{
+    struct th_entry e = h->entries[i];
+    size_t parent;
+
+    while (i > 0) {
+        parent = (i - 1) / TH_ARITY;
+        if (h->entries[parent].key <= e.key)
+            break;
+        thPlace(h, i, h->entries[parent]);
+        i = parent;
+    }
+    thPlace(h, i, e);
+}
+
+static void thSiftDown(struct timer_heap *h, size_t i)
+{
+    struct th_entry e = h->entries[i];
+    size_t child, last, best, c;
+
+    for (;;) {
+        child = i * TH_ARITY + 1;
+        if (child >= h->count)
+            break;
+
+        last = child + TH_ARITY;
+        if (last > h->count)
+            last = h->count;
+
+        best = child;
+        for (c = child + 1; c < last; c++)
+            if (h->entries[c].key < h->entries[best].key)
+                best = c;
+
+        if (e.key <= h->entries[best].key)
+            break;
+        thPlace(h, i, h->entries[best]);
+        i = best;
+    }
+    thPlace(h, i, e);
+}
+
+static int thGrow(struct timer_heap *h)
+{
+    struct th_entry *base;
+    size_t capacity, bytes;
+
+    capacity = h->capacity ? h->capacity * 2 : 64;
+    bytes = (capacity + TH_PAD) * sizeof(struct th_entry);
+    bytes = (bytes + TH_CACHE_LINE - 1) & ~(size_t)(TH_CACHE_LINE - 1);
+
+    base = aligned_alloc(TH_CACHE_LINE, bytes);
+    if (base == NULL)
+        return -1;
+
+    if (h->count > 0)
+        memcpy(base + TH_PAD, h->entries, h->count * sizeof(struct th_entry));
+    free(h->base);
+
+    h->base = base;
+    h->entries = base + TH_PAD;
+    h->capacity = capacity;
+    return 0;
+}
+
+/* Remove the entry at heap position 'i' */
+static void thRemoveAt(struct timer_heap *h, size_t i)
+{
+    struct th_timer *t = h->entries[i].timer;
+
+    t->index = TH_NONE;
+    if (--h->count == i)
+        return;
+
+    /* Move the last entry into the hole and restore heap order */
+    thPlace(h, i, h->entries[h->count]);
+    if (i > 0 && h->entries[i].key < h->entries[(i - 1) / TH_ARITY].key)
+        thSiftUp(h, i);
+    else
+        thSiftDown(h, i);
+}
+
+static void thInsert(struct timer_heap *h, struct th_timer *t)
+{
+    struct th_entry e;
+
+    e.key = thCoalesce(t->expires, t->slack);
+    e.timer = t;
+    h->entries[h->count] = e;
+    t->index = h->count++;
+    thSiftUp(h, t->index);
+}
+
+void thInit(struct timer_heap *h)
+{
+    h->base = NULL;
+    h->entries = NULL;
+    h->count = 0;
+    h->capacity = 0;
+}
+
+void thFree(struct timer_heap *h)
+{
+    size_t i;
+
+    for (i = 0; i < h->count; i++)
+        h->entries[i].timer->index = TH_NONE;
+    free(h->base);
+    thInit(h);
+}
+
+void thTimerInit(struct th_timer *t, th_callback func, void *data)
+{
+    t->expires = 0;
+    t->interval = 0;
+    t->slack = 0;
+    t->index = TH_NONE;
+    t->func = func;
+    t->data = data;
+}
+
+int thPending(const struct th_timer *t)
+{
+    return t->index != TH_NONE;
+}
+
+int thArm(struct timer_heap *h, struct th_timer *t,
+          uint64_t expires, uint64_t interval)
+{
+    t->interval = interval;
+
+    if (thPending(t)) {
+        /* Re-keying in place is cheaper than remove + insert */
+        t->expires = expires;
+        h->entries[t->index].key = thCoalesce(expires, t->slack);
+        if (t->index > 0 && h->entries[t->index].key <
+                h->entries[(t->index - 1) / TH_ARITY].key)
+            thSiftUp(h, t->index);
+        else
+            thSiftDown(h, t->index);
+        return 0;
+    }
+
+    if (h->count == h->capacity && thGrow(h) == -1)
+        return -1;
+
+    t->expires = expires;
+    thInsert(h, t);
+    return 0;
+}
+
+void thCancel(struct timer_heap *h, struct th_timer *t)
+{
+    if (thPending(t))
+        thRemoveAt(h, t->index);
+}
+
+void thSetSlack(struct th_timer *t, uint64_t slack)
+{
+    t->slack = slack;
+}
+
+uint64_t thNextExpiry(const struct timer_heap *h)
+{
+    return h->count > 0 ? h->entries[0].key : UINT64_MAX;
+}
+
+size_t thAdvance(struct timer_heap *h, uint64_t now)
+{
+    struct th_timer *t;
+    uint64_t overrun;
+    size_t fired = 0;
+
+    while (h->count > 0 && h->entries[0].key <= now) {
+        t = h->entries[0].timer;
+
+        overrun = 0;
+        if (t->interval != 0) {
+            /* Fold periods missed while we were late into one callback,
+               and re-key the root in place instead of pop + push */
+            if (now > t->expires)
+                overrun = (now - t->expires) / t->interval;
+            t->expires += (overrun + 1) * t->interval;
+            h->entries[0].key = thCoalesce(t->expires, t->slack);
+            thSiftDown(h, 0);
+        } else {
+            thRemoveAt(h, 0);
+        }
+
+        t->func(t, overrun);
+        fired++;
+    }
+
+    return fired;
+}
@@ -0,0 +1,73 @@
+// timer_heap.h
+#ifndef TIMER_HEAP_H
+#define TIMER_HEAP_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Timer queue backed by an implicit 4-ary min-heap.
+ *
+ * The heap is one contiguous array of {key, timer} pairs, so sifting
+ * compares keys without dereferencing timers, and the four children of a
+ * node share a single 64-byte cache line. Each timer remembers its array
+ * position, which makes cancel O(log n) without searching. Unlike the
+ * timing wheel, memory is proportional to the number of armed timers and
+ * deadlines keep full nanosecond precision.
+ *
+ * A timer may also carry a slack: it may fire up to 'slack' ns late. Its
+ * heap key is then rounded up to a multiple of the largest power of two
+ * not above the slack, so timers with overlapping windows end up with the
+ * same key and are served by a single wakeup.
+ */
+
+#define TH_ARITY 4
+#define TH_NONE  ((size_t)-1)
+
+struct th_timer;
+
+/* Called for each expiration; 'overrun' counts skipped periods */
+typedef void (*th_callback)(struct th_timer *t, uint64_t overrun);
+
+struct th_timer {
+    uint64_t expires;           /* Absolute expiry, in nanoseconds */
+    uint64_t interval;          /* Period in nanoseconds, 0 for one-shot */
+    uint64_t slack;             /* Tolerated lateness, in nanoseconds */
+    size_t index;               /* Heap position, TH_NONE if disarmed */
+    th_callback func;
+    void *data;                 /* Caller's cookie (like sival_ptr) */
+};
+
+struct th_entry {
+    uint64_t key;               /* timer->expires, rounded within slack */
+    struct th_timer *timer;
+};
+
+struct timer_heap {
+    struct th_entry *base;      /* Allocation (cache-line aligned) */
+    struct th_entry *entries;   /* Logical index 0 (offset into 'base') */
+    size_t count;
+    size_t capacity;
+};
+
+void thInit(struct timer_heap *h);
+void thFree(struct timer_heap *h);
+void thTimerInit(struct th_timer *t, th_callback func, void *data);
+
+/* Arm 't' to fire at absolute time 'expires', then every 'interval' ns;
+   returns -1 if the heap could not grow */
+int thArm(struct timer_heap *h, struct th_timer *t,
+          uint64_t expires, uint64_t interval);
+void thCancel(struct timer_heap *h, struct th_timer *t);
+
+/* Allow 't' to fire up to 'slack' ns late; takes effect when next armed */
+void thSetSlack(struct th_timer *t, uint64_t slack);
+int thPending(const struct th_timer *t);
+
+/* Earliest armed expiry, or UINT64_MAX if the heap is empty */
+uint64_t thNextExpiry(const struct timer_heap *h);
+
+/* Run every timer due at or before 'now'; returns callbacks made */
+size_t thAdvance(struct timer_heap *h, uint64_t now);
+
+#endif
@@ -0,0 +1,94 @@
+// timer_pool.c
+#include <stdlib.h>
+#include "timer_pool.h"
+
+#define TP_INDEX_MASK (TP_MAX_TIMERS - 1)
+#define TP_GEN_MASK   ((1u << TP_GEN_BITS) - 1)
+#define TP_NIL        UINT32_MAX      /* End of the free list */
+
+static tp_handle tpMakeHandle(uint32_t index, uint32_t generation)
+{
+    return (generation << TP_INDEX_BITS) | index;
+}
+
+int tpInit(struct timer_pool *pool, uint32_t capacity)
+{
+    uint32_t i;
+
+    if (capacity == 0 || capacity > TP_MAX_TIMERS)
+        return -1;
+
+    pool->records = calloc(capacity, sizeof(struct tp_record));
+    if (pool->records == NULL)
+        return -1;
+
+    /* Generations start at 1 so that no handle is ever TP_INVALID */
+    for (i = 0; i < capacity; i++) {
+        pool->records[i].generation = 1;
+        pool->records[i].nextFree = (i + 1 < capacity) ? i + 1 : TP_NIL;
+    }
+
+    pool->capacity = capacity;
+    pool->freeHead = 0;
+    pool->live = 0;
+    return 0;
+}
+
+void tpFree(struct timer_pool *pool)
+{
+    free(pool->records);
+    pool->records = NULL;
+    pool->capacity = 0;
+    pool->freeHead = TP_NIL;
+    pool->live = 0;
+}
+
+tp_handle tpAlloc(struct timer_pool *pool)
+{
+    struct tp_record *rec;
+    uint32_t index = pool->freeHead;
+
+    if (index == TP_NIL)
+        return TP_INVALID;
+
+    rec = &pool->records[index];
+    pool->freeHead = rec->nextFree;
+    rec->nextFree = TP_NIL;
+    rec->allocated = 1;
+    pool->live++;
+    return tpMakeHandle(index, rec->generation);
+}
+
+void tpRelease(struct timer_pool *pool, tp_handle h)
+{
+    struct tp_record *rec = tpLookup(pool, h);
+    uint32_t index = h & TP_INDEX_MASK;
+
+    if (rec == NULL)
+        return;                 /* Double free or stale handle */
+
+    /* Invalidate outstanding handles; skip 0 when the counter wraps */
+    rec->generation = (rec->generation + 1) & TP_GEN_MASK;
+    if (rec->generation == 0)
+        rec->generation = 1;
+
+    rec->allocated = 0;
+    rec->nextFree = pool->freeHead;
+    pool->freeHead = index;
+    pool->live--;
+}
+
+struct tp_record *tpLookup(const struct timer_pool *pool, tp_handle h)
+{
+    uint32_t index = h & TP_INDEX_MASK;
+    uint32_t generation = h >> TP_INDEX_BITS;
+    struct tp_record *rec;
+
+    if (index >= pool->capacity)
+        return NULL;
+
+    rec = &pool->records[index];
+    if (!rec->allocated || rec->generation != generation)
+        return NULL;
+    return rec;
+}
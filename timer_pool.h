@@ -0,0 +1,53 @@
+// timer_pool.h
+#ifndef TIMER_POOL_H
+#define TIMER_POOL_H
+
+#include <stdint.h>
+#include <time.h>
+
+/*
+ * Slab of timer records addressed by 32-bit generation-counted handles.
+ *
+ * All records are allocated up front, so tpAlloc()/tpRelease() are O(1)
+ * free-list operations that never call malloc. A handle packs the record
+ * index with the record's generation; freeing a record bumps its
+ * generation, so a handle that outlives its timer (e.g. a queued signal
+ * delivered after timer_delete()) no longer resolves in tpLookup().
+ * A handle fits in sival_int, and 0 is never a valid handle.
+ */
+
+#define TP_INDEX_BITS 20
+#define TP_GEN_BITS   (32 - TP_INDEX_BITS)
+#define TP_MAX_TIMERS (1u << TP_INDEX_BITS)
+#define TP_INVALID    0u
+
+typedef uint32_t tp_handle;
+
+struct tp_record {
+    timer_t tid;                /* Kernel timer backing this record */
+    int id;                     /* Caller's label (e.g. spec number) */
+    int periodic;               /* Non-zero if it_interval is set */
+    int allocated;              /* Non-zero while a handle owns it */
+    uint32_t generation;        /* Bumped on every free */
+    uint32_t nextFree;          /* Free-list link (index) */
+};
+
+struct timer_pool {
+    struct tp_record *records;
+    uint32_t capacity;
+    uint32_t freeHead;          /* Index of first free record */
+    uint32_t live;              /* Records currently allocated */
+};
+
+/* Preallocate 'capacity' records; returns -1 on error */
+int tpInit(struct timer_pool *pool, uint32_t capacity);
+void tpFree(struct timer_pool *pool);
+
+/* Returns TP_INVALID if every record is in use */
+tp_handle tpAlloc(struct timer_pool *pool);
+void tpRelease(struct timer_pool *pool, tp_handle h);
+
+/* Async-signal-safe; returns NULL for stale or malformed handles */
+struct tp_record *tpLookup(const struct timer_pool *pool, tp_handle h);
+
+#endif
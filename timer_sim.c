@@ -0,0 +1,421 @@
+#define _GNU_SOURCE
+#include <signal.h>
+#include <stdint.h>
+#include <time.h>
+#include "perf_counters.h"  /* Cache misses per replay */
+#include "timer_heap.h"     /* User-space 4-ary min-heap timer queue */
+#include "timer_trace.h"    /* arm/cancel/expire trace format */
+#include "timer_wheel.h"    /* User-space hierarchical timing wheel */
+#include "tlpi_hdr.h"       /* Error handling functions */
+
+/*
+ * Replays a recorded timer trace (see timer_trace.h) against each timer
+ * engine and reports operations per second, peak memory and cache misses
+ * for the same sequence of operations.
+ *
+ * The user-space engines run on a virtual clock: before each traced
+ * operation the engine is advanced to the operation's timestamp, firing
+ * every expiration due on the way one deadline (or wheel tick) at a time,
+ * so each period of a periodic timer is counted and hours of trace replay
+ * in well under a second. The
+ * kernel backend (one POSIX timer per traced id, as ptmr_sigev_signal.c
+ * does) performs the real timer_create()/timer_settime() calls with the
+ * same SIGEV_SIGNAL notification, the signal blocked and drained with
+ * sigtimedwait() (SIGEV_NONE timers are never queued on the kernel's
+ * hrtimer tree, so they would skip the path being measured). The
+ * kernel's clock cannot be virtualised: timers are armed an hour beyond
+ * their traced deadline so none fires, and its row counts arm and cancel
+ * operations only. Its memory is the kernel slab growth it causes.
+ */
+
+#define USAGE "%s [-g wheel-tick-nsecs] [-b kernel|wheel|heap]... trace-file|-\n"
+
+#define FAR_AWAY 3600000000000ULL       /* Kernel timers: +1 h, never fire */
+#define SIM_SIG  SIGRTMIN               /* Kernel timers' (blocked) signal */
+
+enum backend { BK_KERNEL, BK_WHEEL, BK_HEAP, BK_COUNT };
+
+static const char *backendNames[BK_COUNT] = { "kernel", "wheel", "heap" };
+
+struct sim_result {
+    uint64_t ops;               /* Arms + cancels + expirations */
+    uint64_t expirations;
+    uint64_t wallNs;
+    uint64_t peakBytes;
+    uint64_t cacheMisses;
+    int haveMisses;
+    int hitCeiling;             /* Kernel: timer_create() failed, EAGAIN */
+    long ceiling;               /* Timers created before that */
+};
+
+static struct tt_event *events;
+static size_t nevents;
+static uint32_t maxId;
+static uint64_t tickNs = 1000000;       /* Wheel resolution */
+static struct perf_counters perf;
+static uint64_t fired;                  /* Expirations so far */
+
+static uint64_t nowNs(void)
+{
+    struct timespec ts;
+
+    if (clock_gettime(CLOCK_MONOTONIC, &ts) == -1)
+        errExit("clock_gettime");
+    return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+/* Unreclaimable kernel slab memory (system wide), in bytes */
+static long slabBytes(void)
+{
+    char line[128];
+    long kb = 0;
+    FILE *fp;
+
+    fp = fopen("/proc/meminfo", "r");
+    if (fp == NULL)
+        return 0;
+    while (fgets(line, sizeof(line), fp) != NULL)
+        if (sscanf(line, "SUnreclaim: %ld kB", &kb) == 1)
+            break;
+    fclose(fp);
+    return kb * 1024;
+}
+
+/* Load the whole trace, so parsing is not part of any measurement */
+static void loadTrace(FILE *fp)
+{
+    size_t cap = 0, line = 0;
+    struct tt_event ev;
+    int s;
+
+    while ((s = ttRead(fp, &ev)) != 0) {
+        line++;
+        if (s == -1) {
+            fprintf(stderr, "Malformed trace event %zu ignored\n", line);
+            continue;
+        }
+        if (nevents > 0 && ev.time < events[nevents - 1].time) {
+            fprintf(stderr, "Trace event %zu goes back in time\n", line);
+            exit(EXIT_FAILURE);
+        }
+        if (nevents == cap) {
+            cap = cap ? cap * 2 : 4096;
+            events = realloc(events, cap * sizeof(*events));
+            if (events == NULL)
+                errExit("realloc");
+        }
+        events[nevents++] = ev;
+        if (ev.id > maxId)
+            maxId = ev.id;
+    }
+}
+
+static void perfStart(void)
+{
+    pcBegin(&perf);
+}
+
+static void perfStop(struct sim_result *r)
+{
+    pcEnd(&perf, 0);
+    r->haveMisses = perf.slot[PC_CACHE_MISSES] != -1;
+    r->cacheMisses = perf.total[PC_CACHE_MISSES];
+    memset(perf.total, 0, sizeof(perf.total));
+}
+
+static void simKernel(struct sim_result *r)
+{
+    struct itimerspec its;
+    struct sigevent sev;
+    struct timespec zero = { 0, 0 };
+    sigset_t mask, prevMask;
+    timer_t *tids;
+    char *created;
+    uint64_t t0, deadline;
+    long slab0, slab, ncreated = 0;
+    size_t j;
+
+    tids = calloc(maxId + 1, sizeof(timer_t));
+    created = calloc(maxId + 1, 1);
+    if (tids == NULL || created == NULL)
+        errExit("calloc");
+
+    /* Notify as ptmr_sigev_signal does, but with the signal blocked:
+       nothing should fire, and anything that does is drained below.
+       Each timer reserves a queued signal, so RLIMIT_SIGPENDING may cap
+       how many exist */
+    sigemptyset(&mask);
+    sigaddset(&mask, SIM_SIG);
+    if (sigprocmask(SIG_BLOCK, &mask, &prevMask) == -1)
+        errExit("sigprocmask");
+    memset(&sev, 0, sizeof(sev));
+    sev.sigev_notify = SIGEV_SIGNAL;
+    sev.sigev_signo = SIM_SIG;
+
+    slab0 = slabBytes();
+    perfStart();
+    t0 = nowNs();
+
+    for (j = 0; j < nevents; j++) {
+        struct tt_event *ev = &events[j];
+
+        if (ev->op == TT_EXPIRE)
+            continue;
+
+        if (!created[ev->id]) {
+            if (ev->op == TT_CANCEL || r->hitCeiling)
+                continue;
+            sev.sigev_value.sival_int = ev->id;
+            if (timer_create(CLOCK_MONOTONIC, &sev, &tids[ev->id]) == -1) {
+                if (errno != EAGAIN)
+                    errExit("timer_create");
+                r->hitCeiling = 1;      /* Replay the ids we have */
+                r->ceiling = ncreated;
+                continue;
+            }
+            created[ev->id] = 1;
+            ncreated++;
+        }
+
+        if (ev->op == TT_ARM) {
+            deadline = ev->value + FAR_AWAY;
+            its.it_value.tv_sec = deadline / 1000000000;
+            its.it_value.tv_nsec = deadline % 1000000000;
+            its.it_interval.tv_sec = ev->interval / 1000000000;
+            its.it_interval.tv_nsec = ev->interval % 1000000000;
+        } else {
+            memset(&its, 0, sizeof(its));
+        }
+        if (timer_settime(tids[ev->id], 0, &its, NULL) == -1)
+            errExit("timer_settime");
+        r->ops++;
+    }
+
+    r->wallNs = nowNs() - t0;
+    perfStop(r);
+
+    /* Every timer ever created is still alive: this is the peak */
+    slab = slabBytes() - slab0;
+    r->peakBytes = slab > 0 ? slab : 0;
+
+    for (j = 0; j <= maxId; j++)
+        if (created[j] && timer_delete(tids[j]) == -1)
+            errExit("timer_delete");
+    while (sigtimedwait(&mask, NULL, &zero) != -1)
+        ;
+    if (errno != EAGAIN)
+        errExit("sigtimedwait");
+    if (sigprocmask(SIG_SETMASK, &prevMask, NULL) == -1)
+        errExit("sigprocmask");
+    free(tids);
+    free(created);
+}
+
+/* Engines are stepped from deadline to deadline, so 'overrun' should
+   stay 0; should periods still be folded, they count all the same */
+static void countWheel(struct tw_timer *t, uint64_t overrun)
+{
+    fired += 1 + overrun;
+}
+
+static uint64_t nsToTicks(uint64_t ns)
+{
+    return (ns + tickNs - 1) / tickNs;
+}
+
+/* Step the wheel one tick at a time up to 'now', so every period of a
+   periodic timer fires on its own tick instead of being folded into one
+   late callback; an empty wheel may jump straight there */
+static void wheelAdvanceTo(struct timer_wheel *tw, uint64_t now)
+{
+    while (tw->clk <= now) {
+        if (tw->count == 0) {
+            twAdvance(tw, now);
+            break;
+        }
+        twAdvance(tw, tw->clk);
+    }
+}
+
+static void simWheel(struct sim_result *r)
+{
+    static struct timer_wheel tw;
+    struct tw_timer *timers;
+    uint64_t t0, base = events[0].time;
+    size_t j;
+
+    timers = malloc((maxId + 1) * sizeof(struct tw_timer));
+    if (timers == NULL)
+        errExit("malloc");
+    for (j = 0; j <= maxId; j++)
+        twTimerInit(&timers[j], countWheel, NULL);
+    twInit(&tw, 0);
+    fired = 0;
+
+    perfStart();
+    t0 = nowNs();
+
+    for (j = 0; j < nevents; j++) {
+        struct tt_event *ev = &events[j];
+
+        wheelAdvanceTo(&tw, (ev->time - base) / tickNs);
+        if (ev->op == TT_ARM) {
+            /* Never round a nonzero value or interval down to 0 ticks */
+            twArm(&tw, &timers[ev->id], nsToTicks(ev->value),
+                  nsToTicks(ev->interval));
+            r->ops++;
+        } else if (ev->op == TT_CANCEL) {
+            twCancel(&tw, &timers[ev->id]);
+            r->ops++;
+        }
+    }
+
+    r->wallNs = nowNs() - t0;
+    perfStop(r);
+
+    r->expirations = fired;
+    r->ops += fired;
+    r->peakBytes = sizeof(tw) + (maxId + 1) * sizeof(struct tw_timer);
+    free(timers);
+}
+
+static void countHeap(struct th_timer *t, uint64_t overrun)
+{
+    fired += 1 + overrun;
+}
+
+static void simHeap(struct sim_result *r)
+{
+    struct timer_heap th;
+    struct th_timer *timers;
+    uint64_t t0, now, next, base = events[0].time;
+    size_t j, peakCap = 0;
+
+    timers = malloc((maxId + 1) * sizeof(struct th_timer));
+    if (timers == NULL)
+        errExit("malloc");
+    for (j = 0; j <= maxId; j++)
+        thTimerInit(&timers[j], countHeap, NULL);
+    thInit(&th);
+    fired = 0;
+
+    perfStart();
+    t0 = nowNs();
+
+    for (j = 0; j < nevents; j++) {
+        struct tt_event *ev = &events[j];
+
+        /* Advance deadline by deadline, so no period is folded */
+        now = ev->time - base;
+        while ((next = thNextExpiry(&th)) <= now)
+            thAdvance(&th, next);
+        if (ev->op == TT_ARM) {
+            if (ev->value == 0) {
+                thCancel(&th, &timers[ev->id]);
+            } else {
+                if (thArm(&th, &timers[ev->id], now + ev->value, ev->interval) == -1)
+                    errExit("thArm");
+                if (th.capacity > peakCap)
+                    peakCap = th.capacity;
+            }
+            r->ops++;
+        } else if (ev->op == TT_CANCEL) {
+            thCancel(&th, &timers[ev->id]);
+            r->ops++;
+        }
+    }
+
+    r->wallNs = nowNs() - t0;
+    perfStop(r);
+
+    r->expirations = fired;
+    r->ops += fired;
+    r->peakBytes = (maxId + 1) * sizeof(struct th_timer) +
+                   peakCap * sizeof(struct th_entry);
+    thFree(&th);
+    free(timers);
+}
+
+int main(int argc, char *argv[])
+{
+    int selected[BK_COUNT], nselected = 0, opt, b, j;
+    struct sim_result r;
+    uint64_t traced;
+    char misses[32], expired[32];
+    FILE *fp;
+
+    while ((opt = getopt(argc, argv, "g:b:")) != -1) {
+        switch (opt) {
+        case 'g':
+            tickNs = strtoull(optarg, NULL, 0);
+            break;
+        case 'b':
+            for (b = 0; b < BK_COUNT && strcmp(optarg, backendNames[b]) != 0; b++)
+                continue;
+            if (b == BK_COUNT || nselected == BK_COUNT)
+                usageErr("%s: unknown backend '%s'\n", argv[0], optarg);
+            selected[nselected++] = b;
+            break;
+        default:
+            usageErr(USAGE, argv[0]);
+        }
+    }
+
+    if (optind != argc - 1 || tickNs == 0)
+        usageErr(USAGE, argv[0]);
+
+    if (nselected == 0)
+        for (b = 0; b < BK_COUNT; b++)
+            selected[nselected++] = b;
+
+    fp = (strcmp(argv[optind], "-") == 0) ? stdin : fopen(argv[optind], "r");
+    if (fp == NULL)
+        errExit(argv[optind]);
+    loadTrace(fp);
+    if (fp != stdin)
+        fclose(fp);
+    if (nevents == 0)
+        usageErr("%s: empty trace\n", argv[optind]);
+
+    traced = events[nevents - 1].time - events[0].time;
+    printf("Trace: %zu events, %u timer ids, %.3f s of traced time\n",
+           nevents, maxId + 1, traced / 1e9);
+
+    if (pcOpen(&perf) == -1)
+        fprintf(stderr, "No performance counters: cache misses not reported\n");
+
+    printf("%-7s %12s %12s %12s %10s %14s %10s\n", "backend", "ops",
+           "ops/s", "expirations", "peak-KiB", "cache-misses", "speedup");
+
+    for (j = 0; j < nselected; j++) {
+        memset(&r, 0, sizeof(r));
+        switch (selected[j]) {
+        case BK_KERNEL: simKernel(&r); break;
+        case BK_WHEEL:  simWheel(&r);  break;
+        case BK_HEAP:   simHeap(&r);   break;
+        }
+
+        if (r.haveMisses)
+            snprintf(misses, sizeof(misses), "%llu", (unsigned long long)r.cacheMisses);
+        else
+            snprintf(misses, sizeof(misses), "n/a");
+
+        /* Kernel timers never fire on the virtual clock */
+        if (selected[j] == BK_KERNEL)
+            snprintf(expired, sizeof(expired), "n/a");
+        else
+            snprintf(expired, sizeof(expired), "%llu", (unsigned long long)r.expirations);
+
+        printf("%-7s %12llu %12.0f %12s %10.1f %14s %9.0fx\n",
+               backendNames[selected[j]], (unsigned long long)r.ops,
+               r.wallNs ? r.ops * 1e9 / r.wallNs : 0.0, expired,
+               r.peakBytes / 1024.0, misses,
+               r.wallNs ? (double)traced / r.wallNs : 0.0);
+        if (r.hitCeiling)
+            printf("kernel  replay partial: timer_create() failed with EAGAIN after %ld timers\n",
+                   r.ceiling);
+        fflush(stdout);
+    }
+
+    exit(EXIT_SUCCESS);
+}
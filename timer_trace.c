@@ -0,0 +1,53 @@
+// timer_trace.c
+#include <string.h>
+#include "timer_trace.h"
+
+int ttRead(FILE *fp, struct tt_event *ev)
+{
+    char line[160], op[16];
+    unsigned long long time, value = 0, interval = 0;
+    unsigned id;
+    int n;
+
+    do {
+        if (fgets(line, sizeof(line), fp) == NULL)
+            return 0;
+    } while (line[0] == '#' || line[0] == '\n');
+
+    n = sscanf(line, "%llu %15s %u %llu %llu", &time, op, &id, &value, &interval);
+    if (n < 3)
+        return -1;
+
+    if (strcmp(op, "arm") == 0 && n == 5)
+        ev->op = TT_ARM;
+    else if (strcmp(op, "cancel") == 0)
+        ev->op = TT_CANCEL;
+    else if (strcmp(op, "expire") == 0)
+        ev->op = TT_EXPIRE;
+    else
+        return -1;
+
+    ev->time = time;
+    ev->id = id;
+    ev->value = value;
+    ev->interval = interval;
+    return 1;
+}
+
+void ttWrite(FILE *fp, const struct tt_event *ev)
+{
+    switch (ev->op) {
+    case TT_ARM:
+        fprintf(fp, "%llu arm %u %llu %llu\n", (unsigned long long)ev->time,
+                ev->id, (unsigned long long)ev->value,
+                (unsigned long long)ev->interval);
+        break;
+    case TT_CANCEL:
+        fprintf(fp, "%llu cancel %u\n", (unsigned long long)ev->time, ev->id);
+        break;
+    case TT_EXPIRE:
+        fprintf(fp, "%llu expire %u %llu\n", (unsigned long long)ev->time,
+                ev->id, (unsigned long long)ev->value);
+        break;
+    }
+}
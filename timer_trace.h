@@ -0,0 +1,37 @@
+// timer_trace.h
+#ifndef TIMER_TRACE_H
+#define TIMER_TRACE_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+/*
+ * Text format for timer operation traces, one event per line:
+ *
+ *   <time-ns> arm <id> <value-ns> <interval-ns>
+ *   <time-ns> cancel <id>
+ *   <time-ns> expire <id> <overrun>
+ *
+ * Times are non-decreasing nanoseconds on any clock; 'value' is relative
+ * to the event time (as with timer_settime() without TIMER_ABSTIME) and
+ * an interval of 0 means a one-shot timer. Arming an armed timer re-arms
+ * it. "expire" lines record what happened in the traced process; replay
+ * tools recompute expirations themselves and only count them. Lines
+ * starting with '#' are comments.
+ */
+
+enum tt_op { TT_ARM, TT_CANCEL, TT_EXPIRE };
+
+struct tt_event {
+    uint64_t time;
+    uint32_t id;
+    enum tt_op op;
+    uint64_t value;             /* arm: first expiry; expire: overrun */
+    uint64_t interval;          /* arm only */
+};
+
+/* Returns 1 for an event, 0 at end of file, -1 on a malformed line */
+int ttRead(FILE *fp, struct tt_event *ev);
+void ttWrite(FILE *fp, const struct tt_event *ev);
+
+#endif
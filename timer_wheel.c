@@ -0,0 +1,181 @@
+// timer_wheel.c
+#include "timer_wheel.h"
+
+static void listInit(struct tw_timer *head)
+{
+    head->next = head;
+    head->prev = head;
+}
+
+static void listAddTail(struct tw_timer *head, struct tw_timer *t)
+{
+    t->prev = head->prev;
+    t->next = head;
+    head->prev->next = t;
+    head->prev = t;
+}
+
+static void listDel(struct tw_timer *t)
+{
+    t->prev->next = t->next;
+    t->next->prev = t->prev;
+    t->next = NULL;
+    t->prev = NULL;
+}
+
+/* Move every entry of 'from' onto the (empty) list 'to' */
+static void listSplice(struct tw_timer *from, struct tw_timer *to)
+{
+    if (from->next == from) {
+        listInit(to);
+        return;
+    }
+    to->next = from->next;
+    to->prev = from->prev;
+    to->next->prev = to;
+    to->prev->next = to;
+    listInit(from);
+}
+
+/* Link 't' into the slot matching its absolute expiry */
+static void twAdd(struct timer_wheel *tw, struct tw_timer *t)
+{
+    uint64_t expires = t->expires;
+    int64_t delta = (int64_t)(expires - tw->clk);
+    int lvl;
+
+    if (delta < 0) {
+        /* Already due: run on the very next tick processed */
+        listAddTail(&tw->slots[0][tw->clk & TW_MASK].head, t);
+        return;
+    }
+
+    for (lvl = 0; lvl < TW_LEVELS - 1; lvl++)
+        if ((uint64_t)delta < ((uint64_t)1 << ((lvl + 1) * TW_BITS)))
+            break;
+
+    if (lvl == TW_LEVELS - 1 &&
+            (uint64_t)delta >= ((uint64_t)1 << (TW_LEVELS * TW_BITS)))
+        /* Beyond the wheel's range: park it in the furthest top slot;
+           it is re-placed from its real expiry every time it cascades */
+        expires = tw->clk + ((uint64_t)1 << (TW_LEVELS * TW_BITS)) - 1;
+
+    listAddTail(&tw->slots[lvl][(expires >> (lvl * TW_BITS)) & TW_MASK].head,
+                t);
+}
+
+/* Redistribute one higher-level slot into the levels below it */
+static void twCascade(struct timer_wheel *tw, int lvl, size_t idx)
+{
+    struct tw_timer list, *t;
+
+    listSplice(&tw->slots[lvl][idx].head, &list);
+    while (list.next != &list) {
+        t = list.next;
+        listDel(t);
+        twAdd(tw, t);
+    }
+}
+
+void twInit(struct timer_wheel *tw, uint64_t now)
+{
+    int lvl, i;
+
+    tw->clk = now + 1;          /* Tick 'now' is already in progress */
+    tw->count = 0;
+    for (lvl = 0; lvl < TW_LEVELS; lvl++)
+        for (i = 0; i < TW_SLOTS; i++)
+            listInit(&tw->slots[lvl][i].head);
+}
+
+void twTimerInit(struct tw_timer *t, tw_callback func, void *data)
+{
+    t->next = NULL;
+    t->prev = NULL;
+    t->expires = 0;
+    t->interval = 0;
+    t->func = func;
+    t->data = data;
+}
+
+int twPending(const struct tw_timer *t)
+{
+    return t->next != NULL;
+}
+
+void twArm(struct timer_wheel *tw, struct tw_timer *t,
+           uint64_t value, uint64_t interval)
+{
+    twCancel(tw, t);
+
+    /* As with timer_settime(), a zero value leaves the timer disarmed */
+    if (value == 0)
+        return;
+
+    /* 'clk' is the tick in progress, so counting from the next boundary
+       guarantees the timer never fires early */
+    t->expires = tw->clk + value;
+    t->interval = interval;
+    twAdd(tw, t);
+    tw->count++;
+}
+
+void twCancel(struct timer_wheel *tw, struct tw_timer *t)
+{
+    if (!twPending(t))
+        return;
+    listDel(t);
+    tw->count--;
+}
+
+size_t twAdvance(struct timer_wheel *tw, uint64_t now)
+{
+    struct tw_timer list, *t;
+    uint64_t overrun;
+    size_t fired = 0;
+    size_t idx, i;
+    int lvl;
+
+    while (tw->clk <= now) {
+        if (tw->count == 0) {           /* Nothing armed: skip ahead */
+            tw->clk = now + 1;
+            break;
+        }
+
+        idx = tw->clk & TW_MASK;
+        if (idx == 0) {
+            for (lvl = 1; lvl < TW_LEVELS; lvl++) {
+                i = (tw->clk >> (lvl * TW_BITS)) & TW_MASK;
+                twCascade(tw, lvl, i);
+                if (i != 0)
+                    break;
+            }
+        }
+
+        /* Detach the slot first so callbacks may safely re-arm timers */
+        listSplice(&tw->slots[0][idx].head, &list);
+        tw->clk++;
+
+        while (list.next != &list) {
+            t = list.next;
+            listDel(t);
+            tw->count--;
+
+            overrun = 0;
+            if (t->interval != 0) {
+                /* Like the kernel, fold periods missed while we were late
+                   into one callback and report them as an overrun */
+                if (now > t->expires)
+                    overrun = (now - t->expires) / t->interval;
+                t->expires += (overrun + 1) * t->interval;
+                twAdd(tw, t);
+                tw->count++;
+            }
+
+            t->func(t, overrun);
+            fired++;
+        }
+    }
+
+    return fired;
+}
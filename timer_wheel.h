@@ -0,0 +1,62 @@
+// timer_wheel.h
+#ifndef TIMER_WHEEL_H
+#define TIMER_WHEEL_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Hierarchical timing wheel.
+ *
+ * Logical timers live entirely in user space and are driven by a single
+ * kernel timer that calls twAdvance() once per tick (or whenever it wakes
+ * up). Level 0 has one slot per tick; each higher level covers TW_SLOTS
+ * times the span of the level below and is cascaded down as the clock
+ * passes. Arm and cancel are O(1): a timer is just unlinked from or linked
+ * into a doubly-linked slot list.
+ */
+
+#define TW_BITS   8
+#define TW_SLOTS  (1 << TW_BITS)
+#define TW_MASK   (TW_SLOTS - 1)
+#define TW_LEVELS 4             /* Covers 2^32 ticks (~49 days at 1 ms) */
+
+struct tw_timer;
+
+/* Called for each expiration; 'overrun' counts skipped periods */
+typedef void (*tw_callback)(struct tw_timer *t, uint64_t overrun);
+
+struct tw_timer {
+    struct tw_timer *next;      /* Slot list linkage */
+    struct tw_timer *prev;
+    uint64_t expires;           /* Absolute expiry, in ticks */
+    uint64_t interval;          /* Period in ticks, 0 for one-shot */
+    tw_callback func;
+    void *data;                 /* Caller's cookie (like sival_ptr) */
+};
+
+struct tw_slot {
+    struct tw_timer head;       /* Sentinel of a circular list */
+};
+
+struct timer_wheel {
+    uint64_t clk;               /* Next tick to be processed */
+    size_t count;               /* Number of armed timers */
+    struct tw_slot slots[TW_LEVELS][TW_SLOTS];
+};
+
+/* 'now' is the tick in progress; arms count from the next boundary */
+void twInit(struct timer_wheel *tw, uint64_t now);
+void twTimerInit(struct tw_timer *t, tw_callback func, void *data);
+
+/* Arm 't' to fire 'value' ticks after the current tick, then every
+   'interval' ticks; a zero 'value' leaves it disarmed */
+void twArm(struct timer_wheel *tw, struct tw_timer *t,
+           uint64_t value, uint64_t interval);
+void twCancel(struct timer_wheel *tw, struct tw_timer *t);
+int twPending(const struct tw_timer *t);
+
+/* Run every timer due at or before tick 'now'; returns callbacks made */
+size_t twAdvance(struct timer_wheel *tw, uint64_t now);
+
+#endif
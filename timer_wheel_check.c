@@ -0,0 +1,60 @@
+#include <stdint.h>
+#include "timer_wheel.h"    /* User-space hierarchical timing wheel */
+#include "tlpi_hdr.h"       /* Error handling functions */
+
+/*
+ * Checks timer_wheel.c's promise that a timer never fires early: on a
+ * virtual nanosecond clock, timers are armed at every offset into a tick
+ * (as runWheel() does when it starts mid-tick), the wheel is advanced in
+ * small steps the way a real clock would drive it, and each expiration
+ * must come at least the full timeout after the arm. Exits 1 on failure.
+ */
+
+#define TICK_NS   1000000       /* 1 ms ticks, as in ptmr_sigev_signal */
+#define STEP_NS   10000         /* Virtual clock advances 10 us at a time */
+
+static uint64_t clockNs;        /* Virtual now */
+static uint64_t firedNs;        /* When the timer under test fired */
+
+static void onExpire(struct tw_timer *t, uint64_t overrun)
+{
+    if (firedNs == 0)
+        firedNs = clockNs;
+}
+
+int main(int argc, char *argv[])
+{
+    static struct timer_wheel tw;
+    struct tw_timer t;
+    uint64_t offset, ticks, armNs, timeout;
+    int failures = 0, runs = 0;
+
+    for (offset = 0; offset < TICK_NS; offset += TICK_NS / 10) {
+        for (ticks = 1; ticks <= 300; ticks += 37) {
+            /* Start 'offset' ns into tick 1000, then arm at once */
+            clockNs = armNs = 1000 * TICK_NS + offset;
+            twInit(&tw, clockNs / TICK_NS);
+            twTimerInit(&t, onExpire, NULL);
+            timeout = ticks * TICK_NS;
+            twArm(&tw, &t, ticks, 0);
+
+            firedNs = 0;
+            while (firedNs == 0 && clockNs < armNs + timeout + 3 * TICK_NS) {
+                clockNs += STEP_NS;
+                twAdvance(&tw, clockNs / TICK_NS);
+            }
+
+            runs++;
+            if (firedNs == 0 || firedNs - armNs < timeout) {
+                printf("FAIL: armed %llu ns into a tick for %llu ticks: "
+                       "fired after %lld ns\n", (unsigned long long)offset,
+                       (unsigned long long)ticks,
+                       firedNs ? (long long)(firedNs - armNs) : -1LL);
+                failures++;
+            }
+        }
+    }
+
+    printf("%d of %d wheel timers fired early or not at all\n", failures, runs);
+    exit(failures ? EXIT_FAILURE : EXIT_SUCCESS);
+}
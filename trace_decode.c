@@ -0,0 +1,101 @@
+#include <fcntl.h>
+#include <stdint.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "exp_trace.h"      /* Binary expiration trace format */
+#include "tlpi_hdr.h"       /* Error handling functions */
+
+/*
+ * Converts an expiration trace written by "ptmr_sigev_signal -t file" to
+ * CSV on stdout, oldest record first. Blocks are ordered by sequence
+ * number, so a ring that has wrapped decodes correctly; the number of
+ * blocks lost to wrapping is reported on stderr.
+ */
+
+static int compareSeq(const void *a, const void *b)
+{
+    uint64_t x = (*(const struct et_block_header **)a)->seq;
+    uint64_t y = (*(const struct et_block_header **)b)->seq;
+
+    return (x > y) - (x < y);
+}
+
+int main(int argc, char *argv[])
+{
+    const struct et_file_header *hdr;
+    const struct et_block_header **order, *b;
+    const unsigned char *map, *p, *end;
+    struct et_record rec;
+    struct stat sb;
+    uint64_t j, n, nblocks, records = 0, prev;
+    int fd;
+
+    if (argc != 2 || strcmp(argv[1], "--help") == 0)
+        usageErr("%s trace-file > trace.csv\n", argv[0]);
+
+    fd = open(argv[1], O_RDONLY);
+    if (fd == -1)
+        errExit("open");
+    if (fstat(fd, &sb) == -1)
+        errExit("fstat");
+    if (sb.st_size < ET_BLOCK_SIZE)
+        usageErr("%s: not an expiration trace\n", argv[1]);
+
+    map = mmap(NULL, sb.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (map == MAP_FAILED)
+        errExit("mmap");
+    close(fd);
+
+    hdr = (const struct et_file_header *)map;
+    if (memcmp(hdr->magic, ET_MAGIC, sizeof(hdr->magic)) != 0 ||
+            hdr->version != ET_VERSION || hdr->blockSize != ET_BLOCK_SIZE)
+        usageErr("%s: not an expiration trace (version %d)\n", argv[1], ET_VERSION);
+
+    /* Trust the file size over the header if the file was cut short */
+    nblocks = hdr->nblocks;
+    if ((uint64_t)sb.st_size / ET_BLOCK_SIZE - 1 < nblocks)
+        nblocks = sb.st_size / ET_BLOCK_SIZE - 1;
+
+    order = malloc(nblocks * sizeof(*order));
+    if (order == NULL && nblocks > 0)
+        errExit("malloc");
+
+    for (j = 0, n = 0; j < nblocks; j++) {
+        b = (const struct et_block_header *)(map + (j + 1) * ET_BLOCK_SIZE);
+        if (b->seq != 0 && b->used <= ET_PAYLOAD)
+            order[n++] = b;
+    }
+    qsort(order, n, sizeof(*order), compareSeq);
+
+    if (n > 0 && order[0]->seq > 1)
+        fprintf(stderr, "%llu block(s) overwritten by the ring\n",
+                (unsigned long long)(order[0]->seq - 1));
+
+    printf("spec_id,scheduled_ns,delivered_ns,lateness_ns,overrun\n");
+    for (j = 0; j < n; j++) {
+        b = order[j];
+        p = (const unsigned char *)(b + 1);
+        end = p + b->used;
+        prev = b->base;
+
+        while (p < end) {
+            p = etDecode(p, end, prev, &rec);
+            if (p == NULL) {
+                fprintf(stderr, "Block %llu: truncated record\n",
+                        (unsigned long long)b->seq);
+                break;
+            }
+            printf("%u,%llu,%llu,%lld,%llu\n", rec.id,
+                   (unsigned long long)rec.scheduled,
+                   (unsigned long long)rec.delivered,
+                   (long long)(rec.delivered - rec.scheduled),
+                   (unsigned long long)rec.overrun);
+            prev = rec.delivered;
+            records++;
+        }
+    }
+
+    fprintf(stderr, "%llu record(s) in %llu block(s)\n",
+            (unsigned long long)records, (unsigned long long)n);
+    exit(EXIT_SUCCESS);
+}
@@ -0,0 +1,218 @@
+// tsc_clock.c
+#include <stdio.h>
+#include <string.h>
+#include "tsc_clock.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>
+#include <x86intrin.h>
+#define TC_X86 1
+#endif
+
+#define TC_CAL_NS    20000000   /* Initial calibration window: 20 ms */
+#define TC_PAIR_TRIES 16        /* Reads per pair; the tightest wins */
+
+static uint64_t tcClockNs(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+#ifdef TC_X86
+
+static uint64_t tcRdtsc(void)
+{
+    return __rdtsc();
+}
+
+static int tcInvariant(void)
+{
+    unsigned eax, ebx, ecx, edx;
+
+    if (__get_cpuid(0x80000000, &eax, &ebx, &ecx, &edx) == 0 ||
+            eax < 0x80000007)
+        return 0;
+    __get_cpuid(0x80000007, &eax, &ebx, &ecx, &edx);
+    return (edx >> 8) & 1;
+}
+
+/* A TSC value and the CLOCK_MONOTONIC time at (about) the same instant:
+   the clock read is bracketed by two TSC reads, keeping the tightest */
+static void tcPair(uint64_t *tsc, uint64_t *ns)
+{
+    uint64_t t0, t1, best = UINT64_MAX, now;
+    int j;
+
+    for (j = 0; j < TC_PAIR_TRIES; j++) {
+        t0 = tcRdtsc();
+        now = tcClockNs();
+        t1 = tcRdtsc();
+        if (t1 - t0 < best) {
+            best = t1 - t0;
+            *tsc = t0 + (t1 - t0) / 2;
+            *ns = now;
+        }
+    }
+}
+
+static uint64_t tcConvert(const struct tc_params *p, uint64_t tsc)
+{
+    return p->baseNs +
+           (uint64_t)(((unsigned __int128)(tsc - p->baseTsc) * p->mult) >> 32);
+}
+
+static int tcKernelUsesTsc(void)
+{
+    char name[32] = "";
+    FILE *fp;
+
+    fp = fopen("/sys/devices/system/clocksource/clocksource0/current_clocksource", "r");
+    if (fp == NULL)
+        return 0;
+    if (fgets(name, sizeof(name), fp) == NULL)
+        name[0] = '\0';
+    fclose(fp);
+    return strncmp(name, "tsc", 3) == 0 && (name[3] == '\n' || name[3] == '\0');
+}
+
+#endif
+
+int tcInit(struct tsc_clock *tc)
+{
+#ifdef TC_X86
+    uint64_t tsc0, ns0, tsc1, ns1;
+#endif
+
+    memset(tc, 0, sizeof(*tc));
+    atomic_init(&tc->seq, 0);
+    atomic_flag_clear(&tc->busy);
+
+#ifndef TC_X86
+    tc->why = "not an x86 CPU";
+    return 0;
+#else
+    if (!tcInvariant()) {
+        tc->why = "no invariant TSC";
+        return 0;
+    }
+    if (!tcKernelUsesTsc()) {
+        tc->why = "kernel clocksource is not tsc";
+        return 0;
+    }
+
+    tcPair(&tsc0, &ns0);
+    do
+        tcPair(&tsc1, &ns1);
+    while (ns1 - ns0 < TC_CAL_NS);
+
+    if (tsc1 <= tsc0) {
+        tc->why = "TSC did not advance";
+        return 0;
+    }
+
+    tc->ghz = (double)(tsc1 - tsc0) / (ns1 - ns0);
+    if (tc->ghz < 0.1 || tc->ghz > 10.0) {
+        tc->why = "implausible TSC frequency";
+        return 0;
+    }
+
+    tc->p.baseTsc = tsc1;
+    tc->p.baseNs = ns1;
+    tc->p.mult = (uint64_t)((double)(ns1 - ns0) / (tsc1 - tsc0) * 4294967296.0);
+    tc->calTsc = tsc1;
+    tc->calNs = ns1;
+    tc->recalTicks = (uint64_t)(TC_RECAL_NS * tc->ghz);
+    tc->usable = 1;
+    return 1;
+#endif
+}
+
+#ifdef TC_X86
+
+/* Re-measure the rate over the last interval and plan to absorb the
+   current error over the next one; returns 0 if another recalibration
+   is already in progress. A clock that lags is stepped forward if far
+   off; one that runs ahead keeps its reading and is only slowed */
+static int tcRecalibrate(struct tsc_clock *tc)
+{
+    struct tc_params p;
+    uint64_t tsc, ns, cur;
+    double rate, err, slew;
+    unsigned s;
+
+    if (atomic_flag_test_and_set_explicit(&tc->busy, memory_order_acquire))
+        return 0;                       /* Someone else is at it */
+
+    tcPair(&tsc, &ns);
+    cur = tcConvert(&tc->p, tsc);
+    err = (double)ns - (double)cur;
+    rate = (double)(ns - tc->calNs) / (tsc - tc->calTsc);
+
+    p.baseTsc = tsc;
+    if (err > TC_STEP_NS) {
+        p.baseNs = ns;                  /* Too far behind to slew */
+        err = 0;
+    } else {
+        p.baseNs = cur;                 /* Never step backwards */
+    }
+    slew = 1.0 + err / TC_RECAL_NS;
+    if (slew < TC_MIN_SLEW)
+        slew = TC_MIN_SLEW;             /* The rest waits for next time */
+    p.mult = (uint64_t)(rate * slew * 4294967296.0);
+
+    s = atomic_load_explicit(&tc->seq, memory_order_relaxed);
+    atomic_store_explicit(&tc->seq, s + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    tc->p = p;
+    atomic_store_explicit(&tc->seq, s + 2, memory_order_release);
+
+    tc->ghz = 1.0 / rate;
+    tc->calTsc = tsc;
+    tc->calNs = ns;
+    atomic_flag_clear_explicit(&tc->busy, memory_order_release);
+    return 1;
+}
+
+#endif
+
+uint64_t tcNow(struct tsc_clock *tc)
+{
+#ifdef TC_X86
+    struct tc_params p;
+    uint64_t tsc;
+    unsigned s;
+
+    if (!tc->usable)
+        return tcClockNs();
+
+    s = atomic_load_explicit(&tc->seq, memory_order_acquire);
+    if (s & 1)
+        return tcClockNs();             /* Interrupted a recalibration */
+    p = tc->p;
+    atomic_thread_fence(memory_order_acquire);
+    if (atomic_load_explicit(&tc->seq, memory_order_relaxed) != s)
+        return tcClockNs();
+
+    tsc = tcRdtsc();
+
+    /* The base may postdate our rdtsc (a recalibration, or another CPU) */
+    if ((int64_t)(tsc - p.baseTsc) < 0)
+        return p.baseNs;
+    return tcConvert(&p, tsc);
+#else
+    return tcClockNs();
+#endif
+}
+
+int tcMaintain(struct tsc_clock *tc)
+{
+#ifdef TC_X86
+    if (!tc->usable || tcRdtsc() - tc->calTsc < tc->recalTicks)
+        return 0;
+    return tcRecalibrate(tc);
+#else
+    return 0;
+#endif
+}
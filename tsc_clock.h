@@ -0,0 +1,64 @@
+// tsc_clock.h
+#ifndef TSC_CLOCK_H
+#define TSC_CLOCK_H
+
+#include <stdatomic.h>
+#include <stdint.h>
+#include <time.h>
+
+/*
+ * CLOCK_MONOTONIC nanoseconds from the time stamp counter.
+ *
+ * tcInit() uses the TSC only if the CPU reports an invariant TSC (CPUID
+ * 0x80000007 EDX bit 8) and the kernel itself uses "tsc" as its
+ * clocksource (it switches away when it finds the TSC unreliable, e.g.
+ * unsynchronised across sockets). It then calibrates the TSC against
+ * CLOCK_MONOTONIC. Otherwise, and on non-x86 machines, tcNow() simply
+ * calls clock_gettime().
+ *
+ * A read is rdtsc plus a multiply and shift; tcNow() never recalibrates,
+ * so it stays cheap and async-signal-safe. A normal thread calls
+ * tcMaintain() at least every TC_RECAL_NS (without it the clock keeps its
+ * last calibration): the rate is measured over the whole interval and the
+ * slope is nudged so that any error is worked off during the next
+ * interval. A clock that lags CLOCK_MONOTONIC by more than TC_STEP_NS is
+ * stepped forward; one that runs ahead is never stepped back, only slowed
+ * (to no less than TC_MIN_SLEW of its rate), so readings stay monotonic.
+ * Parameters are published under a sequence lock; a reader that
+ * interrupts a recalibration (e.g. a signal handler) falls back to
+ * clock_gettime() for that one read.
+ */
+
+#define TC_RECAL_NS   1000000000ULL     /* Recalibrate every second */
+#define TC_STEP_NS    1000000           /* Lags beyond 1 ms are stepped */
+#define TC_MIN_SLEW   0.5               /* Slowest slewed rate */
+
+struct tc_params {
+    uint64_t baseTsc;
+    uint64_t baseNs;
+    uint64_t mult;              /* ns per tick, 32.32 fixed point */
+};
+
+struct tsc_clock {
+    int usable;                 /* 0: every read uses clock_gettime() */
+    const char *why;            /* Reason for the fallback */
+    double ghz;                 /* Calibrated TSC frequency */
+    atomic_uint seq;            /* Odd while 'p' is being rewritten */
+    atomic_flag busy;           /* One recalibration at a time */
+    struct tc_params p;
+    uint64_t calTsc;            /* Last calibration pair */
+    uint64_t calNs;
+    uint64_t recalTicks;        /* TC_RECAL_NS in TSC ticks */
+};
+
+/* Returns 1 if the TSC is in use, 0 if reads fall back (see tc->why) */
+int tcInit(struct tsc_clock *tc);
+
+/* Nanoseconds on the CLOCK_MONOTONIC timescale; async-signal-safe */
+uint64_t tcNow(struct tsc_clock *tc);
+
+/* Recalibrate if TC_RECAL_NS has passed since the last calibration;
+   not for signal handlers. Returns 1 if it recalibrated */
+int tcMaintain(struct tsc_clock *tc);
+
+#endif
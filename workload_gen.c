@@ -0,0 +1,241 @@
+#include <math.h>
+#include <stdint.h>
+#include "timer_trace.h"    /* arm/cancel trace format */
+#include "tlpi_hdr.h"       /* Error handling functions */
+
+/*
+ * Synthetic timer workload generator. Writes either a timer trace (see
+ * timer_trace.h, for timer_sim) or, with -s, one timer spec per line for
+ * "ptmr_sigev_signal -f", mixing:
+ *
+ *   arrivals  - one-shot timers armed as a Poisson process (-r per second)
+ *               with heavy-tailed timeouts: Pareto with shape -a and
+ *               minimum -m ns (or exponential/fixed, -d)
+ *   cancels   - each one-shot is cancelled before it fires with
+ *               probability -c, like connection timeouts that almost
+ *               never expire; -S also cancels every pending one-shot at
+ *               once every given ns (a mass cancellation storm)
+ *   fleets    - -F count:period-ns adds 'count' identical periodic timers
+ *               armed together at time 0 (repeatable)
+ *
+ * Specs cannot express arrival times or cancellation, so -s writes each
+ * surviving one-shot with its absolute expiry (arrival + timeout) as the
+ * initial value and leaves out the cancelled ones.
+ */
+
+#define USAGE "%s [-n arrivals] [-r arrivals-per-sec] [-d pareto|exp|fixed] [-a pareto-shape] [-m min-timeout-ns] [-M max-timeout-ns] [-c cancel-prob] [-S storm-every-ns] [-F count:period-ns]... [-R seed] [-s]\n"
+
+#define MAX_FLEETS 16
+
+enum dist { DIST_PARETO, DIST_EXP, DIST_FIXED };
+
+/* A pending one-shot, keyed by when it is cancelled or expires */
+struct pending {
+    uint64_t time;
+    uint32_t id;
+    int cancel;                 /* Emit a cancel at 'time' */
+};
+
+/* Binary min-heap of pending one-shots */
+static struct pending *heap;
+static size_t heapCount, heapCap;
+
+static void heapPush(struct pending p)
+{
+    size_t i, parent;
+
+    if (heapCount == heapCap) {
+        heapCap = heapCap ? heapCap * 2 : 1024;
+        heap = realloc(heap, heapCap * sizeof(*heap));
+        if (heap == NULL)
+            errExit("realloc");
+    }
+
+    for (i = heapCount++; i > 0; i = parent) {
+        parent = (i - 1) / 2;
+        if (heap[parent].time <= p.time)
+            break;
+        heap[i] = heap[parent];
+    }
+    heap[i] = p;
+}
+
+static struct pending heapPop(void)
+{
+    struct pending top = heap[0], last = heap[--heapCount];
+    size_t i = 0, child;
+
+    while ((child = 2 * i + 1) < heapCount) {
+        if (child + 1 < heapCount && heap[child + 1].time < heap[child].time)
+            child++;
+        if (last.time <= heap[child].time)
+            break;
+        heap[i] = heap[child];
+        i = child;
+    }
+    if (heapCount > 0)
+        heap[i] = last;
+    return top;
+}
+
+/* Uniform in (0, 1] */
+static double uniform(void)
+{
+    return 1.0 - drand48();
+}
+
+static uint64_t sampleTimeout(enum dist d, double shape, uint64_t min,
+                              uint64_t max)
+{
+    double v;
+
+    switch (d) {
+    case DIST_PARETO:
+        v = min / pow(uniform(), 1.0 / shape);
+        break;
+    case DIST_EXP:
+        v = min * -log(uniform());
+        break;
+    default:
+        v = min;
+        break;
+    }
+    if (v < 1)
+        v = 1;
+    return (max != 0 && v > max) ? max : (uint64_t)v;
+}
+
+static void emit(int specs, enum tt_op op, uint64_t time, uint32_t id,
+                 uint64_t value, uint64_t interval)
+{
+    struct tt_event ev;
+
+    if (specs) {
+        if (op == TT_ARM)
+            printf("%llu/%llu:%llu/%llu\n",
+                   (unsigned long long)(value / 1000000000),
+                   (unsigned long long)(value % 1000000000),
+                   (unsigned long long)(interval / 1000000000),
+                   (unsigned long long)(interval % 1000000000));
+        return;
+    }
+
+    ev.time = time;
+    ev.op = op;
+    ev.id = id;
+    ev.value = value;
+    ev.interval = interval;
+    ttWrite(stdout, &ev);
+}
+
+/* Release every pending one-shot due before 'now': cancels are written
+   out; an expiry leaves the heap silently in a trace, and with -s is
+   written as a spec for its absolute expiry, since it survived */
+static void drainUntil(int specs, uint64_t now)
+{
+    struct pending p;
+
+    while (heapCount > 0 && heap[0].time <= now) {
+        p = heapPop();
+        if (p.cancel)
+            emit(specs, TT_CANCEL, p.time, p.id, 0, 0);
+        else if (specs)
+            emit(specs, TT_ARM, p.time, p.id, p.time, 0);
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    long fleetCount[MAX_FLEETS];
+    uint64_t fleetPeriod[MAX_FLEETS];
+    long arrivals = 1000000, n, k;
+    double rate = 100000, shape = 1.5, cancelProb = 0.0;
+    uint64_t minTimeout = 1000000000, maxTimeout = 0, stormEvery = 0;
+    uint64_t now = 0, nextStorm, timeout;
+    enum dist d = DIST_PARETO;
+    int nfleets = 0, specs = 0, opt, f;
+    unsigned long long count, period;
+    uint32_t id = 0;
+    struct pending p;
+
+    srand48(1);
+
+    while ((opt = getopt(argc, argv, "n:r:d:a:m:M:c:S:F:R:s")) != -1) {
+        switch (opt) {
+        case 'n': arrivals = atol(optarg);                  break;
+        case 'r': rate = atof(optarg);                      break;
+        case 'a': shape = atof(optarg);                     break;
+        case 'm': minTimeout = strtoull(optarg, NULL, 0);   break;
+        case 'M': maxTimeout = strtoull(optarg, NULL, 0);   break;
+        case 'c': cancelProb = atof(optarg);                break;
+        case 'S': stormEvery = strtoull(optarg, NULL, 0);   break;
+        case 'R': srand48(atol(optarg));                    break;
+        case 's': specs = 1;                                break;
+        case 'd':
+            if (strcmp(optarg, "pareto") == 0)
+                d = DIST_PARETO;
+            else if (strcmp(optarg, "exp") == 0)
+                d = DIST_EXP;
+            else if (strcmp(optarg, "fixed") == 0)
+                d = DIST_FIXED;
+            else
+                usageErr(USAGE, argv[0]);
+            break;
+        case 'F':
+            if (nfleets == MAX_FLEETS ||
+                    sscanf(optarg, "%llu:%llu", &count, &period) != 2 ||
+                    period == 0)
+                usageErr(USAGE, argv[0]);
+            fleetCount[nfleets] = count;
+            fleetPeriod[nfleets++] = period;
+            break;
+        default:
+            usageErr(USAGE, argv[0]);
+        }
+    }
+
+    if (optind != argc || arrivals < 0 || rate <= 0 || shape <= 0 ||
+            minTimeout == 0 || cancelProb < 0 || cancelProb > 1)
+        usageErr(USAGE, argv[0]);
+
+    if (!specs)
+        printf("# workload_gen: %ld arrivals at %.0f/s, cancel %.3f, %d fleet(s)\n",
+               arrivals, rate, cancelProb, nfleets);
+
+    /* Fleets: identical periodic timers, all in phase */
+    for (f = 0; f < nfleets; f++)
+        for (k = 0; k < fleetCount[f]; k++)
+            emit(specs, TT_ARM, 0, id++, fleetPeriod[f], fleetPeriod[f]);
+
+    nextStorm = stormEvery;
+    for (n = 0; n < arrivals; n++) {
+        now += (uint64_t)(-log(uniform()) / rate * 1e9);
+
+        /* Storms first: everything still pending at the storm goes */
+        while (stormEvery != 0 && nextStorm <= now) {
+            drainUntil(specs, nextStorm);
+            while (heapCount > 0) {
+                p = heapPop();
+                emit(specs, TT_CANCEL, nextStorm, p.id, 0, 0);
+            }
+            nextStorm += stormEvery;
+        }
+        drainUntil(specs, now);
+
+        timeout = sampleTimeout(d, shape, minTimeout, maxTimeout);
+        p.id = id++;
+        p.cancel = drand48() < cancelProb;
+
+        /* Cancelled somewhere in its lifetime, else it expires */
+        p.time = now + (p.cancel ? (uint64_t)(timeout * drand48()) : timeout);
+
+        /* With -s the spec is only written once the one-shot survives
+           both its own cancel and any storm (drainUntil()) */
+        if (!specs)
+            emit(specs, TT_ARM, now, p.id, timeout, 0);
+        heapPush(p);
+    }
+    drainUntil(specs, UINT64_MAX);
+
+    exit(EXIT_SUCCESS);
+}